@@ -9,6 +9,24 @@
 #include <ctype.h>
 
 #include "HdmsgHost.h"
+#include "HdmsgSweep.h"
+#include "HdmsgCalibrate.h"
+#include "HdmsgAnalytic.h"
+#include "HdmsgSkew.h"
+#include "HdmsgHdfs.h"
+#include "HdmsgRandom.h"
+#include "HdmsgSpeculate.h"
+#include "HdmsgWorkload.h"
+#include "HdmsgYarn.h"
+#include "HdmsgDisk.h"
+#include "HdmsgTrace.h"
+#include "HdmsgMetrics.h"
+#include "HdmsgPool.h"
+#include "HdmsgConfig.h"
+#include "HdmsgReplicate.h"
+#include "HdmsgGroundTruth.h"
+#include "HdmsgFailure.h"
+#include "HdmsgTopology.h"
 
 #include "simgrid/msg.h"
 #include "xbt/sysdep.h"
@@ -20,12 +38,23 @@
 XBT_LOG_NEW_DEFAULT_CATEGORY(hdmsgCat, "Messages specific for this msg application");
 
 /* Prototypes */
+double get_reference_speed(msg_host_t);
 double get_initialization_cost(msg_host_t);
-double get_map_cost(msg_host_t);
-double get_bytes_to_shuffle();
-double get_reduce_cost(msg_host_t);
+double get_map_cost(msg_host_t, struct HdmsgJob *);
+double get_chunk_map_cost(msg_host_t, double);
+double get_reduce_cost(msg_host_t, struct HdmsgJob *, long);
+double get_partition_reduce_cost(msg_host_t, double);
+double get_merge_cost(msg_host_t, struct HdmsgJob *, long, long);
+double get_compress_cost(msg_host_t, struct HdmsgJob *);
+double get_chunk_compress_cost(msg_host_t, double);
+double get_decompress_cost(msg_host_t, double);
+void map_completed(struct HdmsgJob *);
+void segment_received(struct HdmsgReducer *, double);
+void notify_master(struct HdmsgJob *, const char *, long *);
 double Log2(double);
-void distributeHdfsChunks();
+long get_reducers_to_launch(struct HdmsgJob *, struct HdmsgHost *);
+void distributeHdfsChunks(struct HdmsgJob *);
+void createHdmsgHosts();
 
 /* Process Prototypes */
 int master(int argc, char *argv[]);
@@ -33,18 +62,40 @@ int initializeProcs(int argc, char * argv[]);
 int map(int argc, char * argv[]);
 int shuffleSend(int argc, char * argv[]);
 int shuffleReceive(int argc, char * argv[]);
+int shuffleFetch(int argc, char * argv[]);
 int reduce(int argc, char * argv[]);
 
 /* Constants */
+int BYTES_PER_MEGABYTE = 1048576;
 int SHUFFLERS_PER_REDUCER = 5;
-int SHUFFLE_SLEEP_DURATION = 1;  // In seconds
+int SHUFFLE_RECEIVERS_PER_REDUCER = 5;
+
+// Pull shuffle: instead of senders pushing map output, each reducer runs SHUFFLE_PARALLELCOPIES
+// fetchers (mapreduce.reduce.shuffle.parallelcopies) that copy completed map outputs
+int pull_shuffle = 0;
+int SHUFFLE_PARALLELCOPIES = 5;
+
+// Pipelined reduce: reducers launch once this fraction of the map tasks has completed
+// (mapreduce.job.reduce.slowstart.completedmaps), and merge each segment as it arrives
+int pipelined_reduce = 0;
+double reduce_slowstart = 1.0;
+double reduce_merge_fraction = 0.3;
+
+// Map output size: the combiner keeps combiner_ratio of the map output, and compression
+// shrinks it to compression_ratio of that. Compressing and decompressing cost CPU seconds
+// per uncompressed MB, charged on the mapper and on the reducer's host.
+double combiner_ratio = 1.0;
+double compression_ratio = 1.0;
+double compress_cost_per_mb = 0;
+double decompress_cost_per_mb = 0;
 
 /* Globals */
 double MAP_CALIBRATION_FACTOR;
 double REDUCE_CALIBRATION_FACTOR;
 
 xbt_dict_t hosts;
-xbt_dict_t host_attributes;
+
+struct HdmsgHost *master_host;
 
 int number_of_hosts;
 int number_of_workers;
@@ -58,21 +109,82 @@ long input_size_bytes;
 long hdfs_chunk_size;
 long hdfs_chunk_size_bytes;
 
-double sim_map;
-double sim_reduce;
+// Jobs whose master has not seen them complete. The last one to complete ends the simulation.
+long unfinished_jobs;
 
-int shuffle_started;
+// The job of the last runSimulation, for the reducer report
+static struct HdmsgJob *simulated_job = NULL;
+
+// Blocking MSG calls made by HDMSG processes. Each one is a wake-up the simulator has to schedule.
+long simulation_events;
+
+// Most simulated processes alive at once, sampled whenever the master or workload sampler wakes up
+int peak_processes;
+
+int heterogeneous_speeds = 0;
+double reference_speed = 0;
 
 int ready_inits;
 int ready_mappers;
 int ready_shuffleSenders;
 int ready_reducers;
 
-/* Master Process */
+static void post_master_receive(xbt_dynar_t, const char *);
+
+/** Logs a phase of a job, prefixed with the job's name in a workload */
+static void log_phase(struct HdmsgJob *job, const char *phase)
+{
+    if (job->name != NULL)
+    {
+        XBT_INFO("JOB %s %s", job->name, phase);
+    }
+    else
+    {
+        XBT_INFO("%s", phase);
+    }
+}
+
+/*
+ * Ends a job once its last reducer has reported, or its last mapper and sender if it has no
+ * reducers. Returns 1 if that ended the simulation.
+ */
+static int job_completed(struct HdmsgJob *job)
+{
+    // Maps run again after a crash can complete a job without reducers a second time
+    if (job->finish_time >= 0)
+    {
+        return 0;
+    }
+    
+    job->finish_time = MSG_get_clock();
+    
+    if (job->name != NULL)
+    {
+        XBT_INFO("JOB %s COMPLETE after %.2f seconds", job->name, job->finish_time - job->arrival_time);
+    }
+    
+    if (speculative_execution)
+    {
+        stopSpeculator();
+    }
+    
+    // Crashes still to come, receives a crash left unmatched, DataNodes of killed backups
+    // waiting for their reader, and a workload's sampler would keep the simulation going
+    if (--unfinished_jobs == 0 && (failures_enabled() || speculative_execution || job->queue != NULL))
+    {
+        MSG_process_killall(0);
+        return 1;
+    }
+    
+    return 0;
+}
+
+/* Master Process: runs the job it is given, on its own mailbox */
 int master(int argc, char *argv[])
 {
     char * key;
     struct HdmsgHost *hdmsg_host;
+    struct HdmsgJob *job = MSG_process_get_data(MSG_process_self());
     xbt_dict_cursor_t cursor = NULL;
     
     int i = 0;
@@ -88,17 +200,17 @@ int master(int argc, char *argv[])
     msg_task_t *tasks = xbt_new(msg_task_t, number_of_workers);
     xbt_dynar_t comms = xbt_dynar_new(sizeof(msg_comm_t), NULL);
     
-    XBT_INFO("INITIALIZATION BEGIN");
+    log_phase(job, "INITIALIZATION BEGIN");
     
     // Initialize processes (mappers, shufflers, and reducers) on each host
     xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
     {
         if (hdmsg_host->is_worker)
         {
-            MSG_process_create("Init", initializeProcs, NULL, hdmsg_host->host);
+            MSG_process_create(intern_name("%sInit", job->prefix), initializeProcs, get_job_host(job, hdmsg_host), hdmsg_host->host);
             
             tasks[remaining_inits] = NULL;
-            res_irecv = MSG_task_irecv(&tasks[remaining_inits], "master");
+            res_irecv = MSG_task_irecv(&tasks[remaining_inits], job->mailbox);
             xbt_dynar_push_as(comms, msg_comm_t, res_irecv);
             remaining_inits++;
         }
@@ -107,58 +219,135 @@ int master(int argc, char *argv[])
     while (!xbt_dynar_is_empty(comms))
     {
         xbt_dynar_remove_at(comms, MSG_comm_waitany(comms), &res_irecv);
+        
+        // A message cut off by a crash or a link failure is sent again, or the master reports it itself
+        if (MSG_comm_get_status(res_irecv) != MSG_OK)
+        {
+            MSG_comm_destroy(res_irecv);
+            post_master_receive(comms, job->mailbox);
+            continue;
+        }
+        
         task_com = MSG_comm_get_task(res_irecv);
+        simulation_events++;
+        peak_processes = fmax(peak_processes, MSG_process_get_number());
         
         if (!strcmp(MSG_task_get_name(task_com), "init_exit"))
         {
-            msg_host_t h = MSG_task_get_source(task_com);
+            struct HdmsgJobHost *job_host = get_job_host(job, get_hdmsg_host(MSG_task_get_source(task_com)));
             MSG_task_destroy(task_com);
             
-            const char *host_name = MSG_host_get_name(h);
-            struct HdmsgHost *hdmsg_host = xbt_dict_get(hosts, host_name);
-            
-            remaining_mappers += get_mapper_count(hdmsg_host);
-            remaining_shufflers += get_shuffler_count(hdmsg_host);
-            remaining_reducers += get_reducer_count(hdmsg_host);
+            remaining_mappers += get_mapper_count(job_host);
+            remaining_shufflers += get_shuffler_count(job_host);
+            remaining_reducers += get_reducer_count(job_host);
             
             remaining_inits--;
             
             if (remaining_inits == 0)
             {
-                XBT_INFO("INITIALIZATION COMPLETE");
+                log_phase(job, "INITIALIZATION COMPLETE");
+                buildReducerTable(job);
                 
                 // Add an extra message to account for the message sent when the shuffle phase begins
                 expected_messages = 1 + remaining_mappers + remaining_shufflers + remaining_reducers;
                 
+                // and one more for the message sent when slow-start launches the reducers
+                if (pipelined_reduce && reduce_slowstart > 0)
+                {
+                    expected_messages++;
+                }
+                
+                // and, with failures, one for each crash the master will notice and one if the job fails
+                if (failures_enabled())
+                {
+                    expected_messages += countScheduledCrashes() + 1;
+                }
+                
                 free(tasks);
                 tasks = xbt_new(msg_task_t, expected_messages);
                 
                 for (i = 0; i < expected_messages; i++)
                 {
                     tasks[i] = NULL;
-                    res_irecv = MSG_task_irecv(&tasks[i], "master");
+                    res_irecv = MSG_task_irecv(&tasks[i], job->mailbox);
                     xbt_dynar_push_as(comms, msg_comm_t, res_irecv);
                 }
                 
-                XBT_INFO("MAP PHASE BEGIN");
+                log_phase(job, "MAP PHASE BEGIN");
+                TRACE_PHASE("MAP PHASE BEGIN");
+                
+                if (speculative_execution)
+                {
+                    startSpeculator(master_host);
+                }
+                
+                if (failures_enabled())
+                {
+                    startFailureInjector(job, master_host);
+                }
                 
                 // Activate Mappers
                 xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
                 {
-                    activate_mappers(hdmsg_host);
+                    activate_mappers(get_job_host(job, hdmsg_host));
+                }
+                
+                if (pipelined_reduce && reduce_slowstart <= 0)
+                {
+                    job->reduce_started = 1;
+                    log_phase(job, "REDUCE PHASE BEGIN");
+                    TRACE_PHASE("REDUCE PHASE BEGIN");
+                    
+                    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+                    {
+                        activate_reducers(get_job_host(job, hdmsg_host));
+                    }
                 }
             }
         }
         else if (!strcmp(MSG_task_get_name(task_com), "shuffle_start"))
         {
-            XBT_INFO("SHUFFLE PHASE BEGIN");
+            log_phase(job, "SHUFFLE PHASE BEGIN");
+            TRACE_PHASE("SHUFFLE PHASE BEGIN");
+        }
+        else if (!strcmp(MSG_task_get_name(task_com), "reduce_start"))
+        {
+            char phase[64];
+            snprintf(phase, sizeof(phase), "REDUCE PHASE BEGIN (%ld of %ld maps completed)", job->completed_maps, job->map_tasks);
+            log_phase(job, phase);
+            TRACE_PHASE("REDUCE PHASE BEGIN");
+            
+            // Activate Reducers
+            xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+            {
+                activate_reducers(get_job_host(job, hdmsg_host));
+            }
         }
         else if (!strcmp(MSG_task_get_name(task_com), "map_exit"))
         {
             remaining_mappers--;
             if (remaining_mappers == 0)
             {
-                XBT_INFO("MAP PHASE COMPLETE");
+                log_phase(job, "MAP PHASE COMPLETE");
+                TRACE_PHASE("MAP PHASE COMPLETE");
+                
+                // Pulling reducers copy the map output themselves once they are launched. Maps run
+                // again after a crash can complete the map phase a second time.
+                if (pull_shuffle && !pipelined_reduce && !job->reducers_launched)
+                {
+                    log_phase(job, "REDUCE PHASE BEGIN");
+                    TRACE_PHASE("REDUCE PHASE BEGIN");
+                    
+                    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+                    {
+                        activate_reducers(get_job_host(job, hdmsg_host));
+                    }
+                }
+                
+                if (job->reducers == 0 && remaining_shufflers == 0 && job_completed(job))
+                {
+                    break;
+                }
             }
         }
         else if (!strcmp(MSG_task_get_name(task_com), "shuffle_exit"))
@@ -166,13 +355,24 @@ int master(int argc, char *argv[])
             remaining_shufflers--;
             if (remaining_shufflers == 0)
             {
-                XBT_INFO("SHUFFLE PHASE COMPLETE");
-                XBT_INFO("REDUCE PHASE BEGIN");
+                log_phase(job, "SHUFFLE PHASE COMPLETE");
+                TRACE_PHASE("SHUFFLE PHASE COMPLETE");
                 
-                // Activate Reducers
-                xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+                if (!pipelined_reduce && !pull_shuffle)
                 {
-                    activate_reducers(hdmsg_host);
+                    log_phase(job, "REDUCE PHASE BEGIN");
+                    TRACE_PHASE("REDUCE PHASE BEGIN");
+                    
+                    // Activate Reducers
+                    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+                    {
+                        activate_reducers(get_job_host(job, hdmsg_host));
+                    }
+                }
+                
+                if (job->reducers == 0 && remaining_mappers == 0 && job_completed(job))
+                {
+                    break;
                 }
             }
         }
@@ -181,9 +381,39 @@ int master(int argc, char *argv[])
             remaining_reducers--;
             if (remaining_reducers == 0)
             {
-                XBT_INFO("REDUCE PHASE COMPLETE");
+                log_phase(job, "REDUCE PHASE COMPLETE");
+                TRACE_PHASE("REDUCE PHASE COMPLETE");
+                
+                if (job_completed(job))
+                {
+                    break;
+                }
+            }
+        }
+        else if (!strcmp(MSG_task_get_name(task_com), "host_lost"))
+        {
+            long added[3] = { 0, 0, 0 };
+            recoverLostHost(job, MSG_task_get_data(task_com), added);
+            MSG_task_destroy(task_com);
+            
+            // The tasks started again report to the master like the ones they replace
+            remaining_mappers += added[0];
+            remaining_shufflers += added[1];
+            remaining_reducers += added[2];
+            
+            for (i = 0; i < added[0] + added[1] + added[2]; i++)
+            {
+                post_master_receive(comms, job->mailbox);
             }
         }
+        else if (!strcmp(MSG_task_get_name(task_com), "job_failed"))
+        {
+            log_phase(job, "JOB FAILED");
+            TRACE_PHASE("JOB FAILED");
+            MSG_task_destroy(task_com);
+            MSG_process_killall(0);
+            break;
+        }
         else
         {
             printf("*** MAP PHASE ERROR Received unexpected task: %s\n", MSG_task_get_name(task_com));
@@ -195,99 +425,228 @@ int master(int argc, char *argv[])
     return 0;
 }                               /* end_of_master */
 
+/** Posts one more receive on a master's mailbox, for a message the master did not count on at first */
+static void post_master_receive(xbt_dynar_t comms, const char *mailbox)
+{
+    msg_task_t *task = arena_alloc(sizeof(msg_task_t));
+    msg_comm_t comm = MSG_task_irecv(task, mailbox);
+    xbt_dynar_push_as(comms, msg_comm_t, comm);
+}
+
 /** Initialize Processes */
 int initializeProcs(int argc, char * argv[])
 {
-    // Get the current host
-    const char * host_name = MSG_host_get_name(MSG_process_get_host(NULL));
-    struct HdmsgHost * this_host = xbt_dict_get(hosts, host_name);
+    // Get the current host and the job it is initialized for
+    struct HdmsgJobHost * job_host = MSG_process_get_data(MSG_process_self());
+    struct HdmsgJob * job = job_host->job;
+    struct HdmsgHost * this_host = job_host->host;
+    const char * host_name = this_host->host_name;
     
     int i;
-    long mappers_to_launch = MSG_host_get_core_number(this_host->host);
-    long reducers_to_launch = reducers / number_of_workers;
+    long mappers_to_launch = get_map_slots(this_host);
+    long reducers_to_launch = get_reducers_to_launch(job, this_host);
     
-    // If the number of reducers is not divisible by the number of workers,
-    // allocate the remaining reducers
-    if (reducers % number_of_workers != 0)
-    {
-        if (this_host->host_id <= (reducers % number_of_workers))
-        {
-            reducers_to_launch++;
-        }
-    }
+    // Pipelined reducers hold their containers while the maps run. Without reduce preemption
+    // they must leave room for a map container, or the host's maps could never start.
+    xbt_assert(!containers_enabled() || !pipelined_reduce ||
+               (reducers_to_launch * reduce_container_mb + map_container_mb <= this_host->memory_mb &&
+                reducers_to_launch * reduce_container_vcores + map_container_vcores <= this_host->vcores),
+               "The reduce containers on %s leave no room for a map container", host_name);
+    
+    // Senders block on this until mappers post shuffle tasks
+    job_host->shuffle_work = MSG_sem_init(0);
     
     // Create mappers
     mappers += mappers_to_launch;
     for (i = 0; i < mappers_to_launch; i++)
     {
-        char * mapper_name = bprintf("%s-Mapper-%d", host_name, i);
-        msg_process_t mapper = MSG_process_create(mapper_name, map, NULL, this_host->host);
-        xbt_fifo_push(this_host->mappers, mapper);
-        this_host->active_mappers++;
+        createMapper(job_host);
     }
     
-    // Create shufflers
+    // Create shufflers. A host without reducers still has map output to send.
     long number_of_shufflers = SHUFFLERS_PER_REDUCER * reducers_to_launch;
+    if (number_of_shufflers == 0)
+    {
+        number_of_shufflers = SHUFFLERS_PER_REDUCER;
+    }
+    
+    // Pulling reducers fetch the map output, so nothing is sent
+    if (pull_shuffle)
+    {
+        number_of_shufflers = 0;
+    }
+    
     for (i = 0; i < number_of_shufflers; i++)
     {
-        char * sender_name = bprintf("%s-Sender-%d", host_name, i);
-        msg_process_t sender = MSG_process_create(sender_name, shuffleSend, NULL, this_host->host);
-        xbt_fifo_push(this_host->shuffle_senders, sender);
+        char * sender_name = intern_name("%s%s-Sender-%d", job->prefix, host_name, i);
+        msg_process_t sender = MSG_process_create(sender_name, shuffleSend, job_host, this_host->host);
+        xbt_fifo_push(job_host->shuffle_senders, sender);
     }
     
-    // Create reducers
+    // Create reducers, each with a fixed pool of shuffle receivers on its own mailbox
     for (i = 0; i < reducers_to_launch; i++)
     {
-        char * reducer_name = bprintf("%s-Reducer", host_name);
-        msg_process_t reducer = MSG_process_create(reducer_name, reduce, NULL, this_host->host);
-        xbt_fifo_push(this_host->reducers, reducer);
+        createReducer(job, this_host, job->next_partition++);
     }
     
     // The cost of this task should be equal to the overhead of starting these processes
-    MSG_task_execute(MSG_task_create("initialization", get_initialization_cost(this_host->host), 0, NULL));
+    execute_task("initialization", get_initialization_cost(this_host->host));
     
     // Notify master that initialization on this host is complete
-    MSG_task_send(MSG_task_create("init_exit", 0, 1, NULL), "master");
+    MSG_task_send(MSG_task_create("init_exit", 0, 1, NULL), job->mailbox);
+    simulation_events += 2;
     
     return 0;
 }
 
+/** Creates a mapper on a host. It waits for the master unless the mappers have been launched already. */
+msg_process_t createMapper(struct HdmsgJobHost *job_host)
+{
+    char * mapper_name = intern_name("%s%s-Mapper-%d", job_host->job->prefix, job_host->host->host_name, get_mapper_count(job_host));
+    msg_process_t mapper = MSG_process_create(mapper_name, map, job_host, job_host->host->host);
+    xbt_fifo_push(job_host->mappers, mapper);
+    job_host->active_mappers++;
+    
+    return mapper;
+}
+
+/** Creates the reducer of a job's partition on a host, with its shuffle receivers or fetchers */
+struct HdmsgReducer *createReducer(struct HdmsgJob *job, struct HdmsgHost *this_host, long partition)
+{
+    int j;
+    struct HdmsgJobHost *job_host = get_job_host(job, this_host);
+    struct HdmsgReducer *reducer = newHdmsgReducer(job, get_reducer_count(job_host), partition, this_host, job->map_tasks);
+    
+    // A reducer that can lose map outputs to a crash must know which ones it already has
+    if (host_failures_enabled())
+    {
+        reducer->fetched_blocks = arena_alloc(reducer->expected_segments);
+    }
+    
+    reducer->process = MSG_process_create(reducer->mailbox, reduce, reducer, this_host->host);
+    xbt_fifo_push(job_host->reducers, reducer);
+    
+    for (j = 0; j < SHUFFLE_RECEIVERS_PER_REDUCER && reducer->expected_segments > 0 && !pull_shuffle; j++)
+    {
+        char * receiver_name = intern_name("%s-Receiver-%d", reducer->mailbox, j);
+        msg_process_t receiver = MSG_process_create(receiver_name, shuffleReceive, reducer, this_host->host);
+        xbt_fifo_push(reducer->receivers, receiver);
+    }
+    
+    for (j = 0; j < SHUFFLE_PARALLELCOPIES && reducer->expected_segments > 0 && pull_shuffle; j++)
+    {
+        char * fetcher_name = intern_name("%s-Fetcher-%d", reducer->mailbox, j);
+        msg_process_t fetcher = MSG_process_create(fetcher_name, shuffleFetch, reducer, this_host->host);
+        xbt_fifo_push(reducer->receivers, fetcher);
+    }
+    
+    return reducer;
+}
+
 /** Map Process */
 int map(int argc, char * argv[])
 {
+    int i;
     double start_time;
+    struct HdmsgJobHost * job_host = MSG_process_get_data(MSG_process_self());
+    struct HdmsgJob * job = job_host->job;
     
-    double bytes_to_shuffle = get_bytes_to_shuffle();
-    MSG_process_suspend(MSG_process_self());
+    // Wait for the master, unless this mapper replaces work lost to a crash
+    if (!job->mappers_launched)
+    {
+        MSG_process_suspend(MSG_process_self());
+        simulation_events++;
+    }
     
     msg_host_t msg_host = MSG_process_get_host(MSG_process_self());
-    struct HdmsgHost * this_host = xbt_dict_get(hosts, MSG_host_get_name(msg_host));
+    struct HdmsgHost * this_host = job_host->host;
+    int waited = 0;
     
-    while (xbt_fifo_size(this_host->map_tasks) > 0)
+    // With work stealing, a mapper that runs out of local tasks takes one from the most loaded host.
+    // A blacklisted host takes no work from others.
+    while (xbt_fifo_size(job_host->map_tasks) > 0 ||
+           (work_stealing && !this_host->blacklisted && steal_map_task(job_host, &waited)))
     {
         // Do map tasks
-        msg_task_t map_task = xbt_fifo_pop(this_host->map_tasks);
+        struct HdfsBlock *block = xbt_fifo_pop(job_host->map_tasks);
         
-        if (map_task != NULL)
+        if (block != NULL)
         {
             XBT_INFO("%s is starting a map task", MSG_process_get_name(MSG_process_self()));
             start_time = MSG_get_clock();
-            MSG_task_execute(map_task);
-            sim_map += MSG_get_clock() - start_time;
+            block->map_host = this_host;
+            allocate_container(this_host, CONTAINER_MAP, job);
+            
+            if (job->start_time < 0)
+            {
+                job->start_time = MSG_get_clock();
+            }
+            
+            // A map scheduled away from its block's replicas reads the block over the network first
+            if (block->source != NULL)
+            {
+                readRemoteBlock(job, block);
+            }
+            else
+            {
+                disk_read(this_host, job->hdfs_chunk_size_bytes);
+            }
+            
+            // A failed attempt wastes part of the task, which is scheduled again
+            if (failAttempt(job, this_host, get_map_cost(msg_host, job), "map"))
+            {
+                release_container(this_host, CONTAINER_MAP, job);
+                retryMapTask(job_host, block);
+                continue;
+            }
+            
+            // A backup copy may finish first, in which case it sends the output itself
+            msg_task_t map_task = MSG_task_create("map", get_map_cost(msg_host, job), 0, block);
+            int produced_output = executeMapTask(job_host, map_task);
+            
+            if (produced_output && compress_cost_per_mb > 0)
+            {
+                execute_task("compress", get_compress_cost(msg_host, job));
+                simulation_events++;
+            }
+            
+            if (produced_output)
+            {
+                spillMapOutput(this_host, job->hdfs_chunk_size_bytes * combiner_ratio);
+            }
+            
+            release_container(this_host, CONTAINER_MAP, job);
+            
+            job->sim_map += MSG_get_clock() - start_time;
+            this_host->busy_time += MSG_get_clock() - start_time;
+            METRICS_BUSY(this_host, start_time);
+            METRICS_TASK(METRICS_MAP, start_time);
+            TRACE_SPAN("map", "map", start_time, job->hdfs_chunk_size_bytes);
             MSG_task_destroy(map_task);
             XBT_INFO("%s has completed a map task", MSG_process_get_name(MSG_process_self()));
             
-            // Partition map output for shufflers to retrieve
-            partition_map_task(this_host, bytes_to_shuffle);
+            if (produced_output)
+            {
+                // Partition map output for shufflers to retrieve
+                partition_map_task(job_host, block);
+                map_completed(job);
+            }
         }
     }
     
-    this_host->active_mappers--;
+    job_host->active_mappers--;
+    
+    // The last mapper wakes every sender so idle ones see the empty queue and exit
+    if (job_host->active_mappers == 0)
+    {
+        for (i = 0; i < get_shuffler_count(job_host); i++)
+        {
+            MSG_sem_release(job_host->shuffle_work);
+        }
+    }
     
     // Notify master that I'm done working
-    msg_comm_t comm = MSG_task_isend(MSG_task_create("map_exit", 0, 1, NULL), "master");
-    MSG_comm_wait(comm, -1);
-    MSG_comm_destroy(comm);
+    notify_master(job, "map_exit", &job_host->reported_mappers);
     
     return 0;
 }
@@ -296,55 +655,56 @@ int map(int argc, char * argv[])
 /** Shuffle Send Process */
 int shuffleSend(int argc, char * argv[])
 {
-    msg_task_t task = NULL;
-    
-    const char * process_name = MSG_process_get_name(MSG_process_self());
-    
-    msg_host_t msg_host = MSG_process_get_host(MSG_process_self());
-    struct HdmsgHost * this_host = xbt_dict_get(hosts, MSG_host_get_name(msg_host));
+    struct HdmsgJobHost * job_host = MSG_process_get_data(MSG_process_self());
+    struct HdmsgJob * job = job_host->job;
+    struct HdmsgHost * this_host = job_host->host;
     
     while (1)
     {
-        task = xbt_fifo_shift(this_host->shuffle_tasks);
+        // Block until a mapper posts a shuffle task, or the last mapper on this host exits
+        MSG_sem_acquire(job_host->shuffle_work);
+        simulation_events++;
         
-        if (task != NULL)
+        struct HdmsgReducer *recipient = take_shuffle_task(job_host);
+        
+        if (recipient == NULL)
         {
-            // If this is the first shuffle task, notify the master so the event is logged to the console
-            if (!shuffle_started)
-            {
-                shuffle_started = 1;
-                MSG_task_dsend(MSG_task_create("shuffle_start", 0, 1, NULL), "master", NULL);
-            }
-            
-            // Create a shuffle receiver on the recipient host
-            msg_host_t recipient_host = MSG_task_get_data(task);
-            char * receiver_name = bprintf("%s->%s-Receiver", process_name, MSG_host_get_name(recipient_host));
-            MSG_process_create(receiver_name, shuffleReceive, NULL, recipient_host);
-            
-            // Send the task to the shuffle receiver
-            XBT_INFO("%s is starting a shuffle task", MSG_process_get_name(MSG_process_self()));
-            MSG_task_send(task, receiver_name);
-            XBT_INFO("%s has completed a shuffle task", MSG_process_get_name(MSG_process_self()));
+            // Every task was posted before the last mapper exited, so there is no further work
+            break;
         }
-        else
+        
+        // If this is the first shuffle task, notify the master so the event is logged to the console
+        if (!job->shuffle_started)
         {
-            if (this_host->active_mappers > 0)
-            {
-                // If there are still active mappers, sleep then check for more work
-                MSG_process_sleep(SHUFFLE_SLEEP_DURATION);
-            }
-            else
-            {
-                // Else no mappers -> no further tasks, exit
-                break;
-            }
+            job->shuffle_started = 1;
+            MSG_task_dsend(MSG_task_create("shuffle_start", 0, 1, NULL), job->mailbox, NULL);
+        }
+        
+        // Send the segment to the recipient reducer's receivers
+        double bytes = get_bytes_to_shuffle(job, recipient->partition);
+        double start_time = MSG_get_clock();
+        XBT_INFO("%s is starting a shuffle task", MSG_process_get_name(MSG_process_self()));
+        disk_read(this_host, bytes);
+        double send_time = MSG_get_clock();
+        
+        // A segment cut off by a link failure is sent again
+        msg_task_t segment = MSG_task_create("shuffle", 0, bytes, recipient);
+        while (MSG_task_send(segment, recipient->mailbox) != MSG_OK)
+        {
+            MSG_task_destroy(segment);
+            waitToRetry();
+            segment = MSG_task_create("shuffle", 0, bytes, recipient);
         }
+        simulation_events++;
+        recordShuffleTraffic(this_host, recipient->host, send_time, bytes);
+        METRICS_LINK(this_host, recipient->host, send_time, bytes);
+        METRICS_TASK(METRICS_SHUFFLE, start_time);
+        TRACE_SPAN("shuffle", "send", start_time, bytes);
+        XBT_INFO("%s has completed a shuffle task", MSG_process_get_name(MSG_process_self()));
     }
     
     // Notify master that I'm done working
-    msg_comm_t comm = MSG_task_isend(MSG_task_create("shuffle_exit", 0, 1, NULL), "master");
-    MSG_comm_wait(comm, -1);
-    MSG_comm_destroy(comm);
+    notify_master(job, "shuffle_exit", &job_host->reported_shufflers);
     
     return 0;
 }
@@ -353,216 +713,450 @@ int shuffleSend(int argc, char * argv[])
 /** Shuffle Receive Process */
 int shuffleReceive(int argc, char * argv[])
 {
-    int res;
+    int res, i;
     msg_task_t task = NULL;
+    struct HdmsgReducer *reducer = MSG_process_get_data(MSG_process_self());
     
-    res = MSG_task_receive(&(task), MSG_process_get_name(MSG_process_self()));
-    xbt_assert(res == MSG_OK, "MSG_task_get failed: Shuffle Receive");
-    MSG_task_destroy(task);
-    
-    return 0;
-}
-
-/** Reduce Process */
-int reduce(int argc, char * argv[])
-{
-    double start_time;
-    
-    // Wait for the reduce phase to begin
-    MSG_process_suspend(MSG_process_self());
-    
-    XBT_INFO("%s is starting a reduce task", MSG_process_get_name(MSG_process_self()));
-    start_time = MSG_get_clock();
-    MSG_task_execute(MSG_task_create("reduce", get_reduce_cost(MSG_host_self()), 0, NULL));
-    sim_reduce += MSG_get_clock() - start_time;
-    XBT_INFO("%s has completed a reduce task", MSG_process_get_name(MSG_process_self()));
+    // Pipelined receivers wait for slow-start to launch their reducer
+    if (pipelined_reduce)
+    {
+        MSG_process_suspend(MSG_process_self());
+        simulation_events++;
+    }
     
-    // Notify the master that I'm done working
-    msg_comm_t comm = MSG_task_isend(MSG_task_create("reduce_exit", 0, 1, NULL), "master");
-    MSG_comm_wait(comm, -1);
-    MSG_comm_destroy(comm);
+    while (1)
+    {
+        task = NULL;
+        double start_time = MSG_get_clock();
+        res = MSG_task_receive(&(task), reducer->mailbox);
+        simulation_events++;
+        
+        // Its sender sends a segment a link failure cut off again
+        if (res != MSG_OK)
+        {
+            continue;
+        }
+        
+        if (!strcmp(MSG_task_get_name(task), "shuffle_done"))
+        {
+            MSG_task_destroy(task);
+            break;
+        }
+        
+        // The span includes the wait for a sender, so stalls show up in the trace
+        segment_received(reducer, MSG_task_get_bytes_amount(task));
+        TRACE_SPAN("shuffle", "receive", start_time, MSG_task_get_bytes_amount(task));
+        MSG_task_destroy(task);
+        
+        if (reducer->received_segments == reducer->expected_segments)
+        {
+            // That was the last segment. Release the rest of the pool, still waiting on the mailbox.
+            for (i = 1; i < xbt_fifo_size(reducer->receivers); i++)
+            {
+                MSG_task_dsend(MSG_task_create("shuffle_done", 0, 0, NULL), reducer->mailbox, NULL);
+            }
+            break;
+        }
+    }
     
     return 0;
 }
 
-/** Main function */
-int main(int argc, char *argv[])
+/*
+ * Copies one map output to a reducer. Returns 0 if the output's host was lost, in which case
+ * the output comes from the map's next run.
+ */
+static int fetch_map_output(struct HdmsgReducer *reducer, struct MapOutput *output, double bytes)
 {
-    int i, BYTES_PER_MEGABYTE = 1048576;
-    char *config_path;
-    char *platform_path;
-    
-    msg_error_t res = MSG_OK;
-    MSG_init(&argc, argv);
+    double start_time = MSG_get_clock();
     
-    if (argc != 5)
+    if (output->host == reducer->host)
     {
-        printf("Usage: %s map_cf reduce_cf config platform.xml\n", argv[0]);
-        printf("Example: %s 0.28 0.29 path_to_config path_to_platform.xml \n", argv[0]);
-        exit(1);
+        disk_read(output->host, bytes);
+        recordShuffleTraffic(output->host, reducer->host, start_time, bytes);
+        return 1;
     }
     
-    // Set calibration factors
-    sscanf(argv[1], "%lf", &MAP_CALIBRATION_FACTOR);
-    sscanf(argv[2], "%lf", &REDUCE_CALIBRATION_FACTOR);
-    
-    // Set file paths
-    config_path = malloc(strlen(argv[3]) * sizeof(char));
-    strcpy(config_path, argv[3]);
-    
-    platform_path = malloc(strlen(argv[4]) * sizeof(char));
-    strcpy(platform_path, argv[4]);
-    
-    // Register the functions
-    MSG_function_register("master", master);
-    MSG_function_register("initializeProcs", initializeProcs);
-    
-    MSG_function_register("map", map);
-    MSG_function_register("reduce", reduce);
-    
-    MSG_function_register("shuffleSend", shuffleSend);
-    MSG_function_register("shuffleReceive", shuffleReceive);
+    while (receiveFromHost(output->host, bytes) != MSG_OK)
+    {
+        if (!retryMapOutput(reducer, output))
+        {
+            return 0;
+        }
+    }
     
-    // Create the environment
-    MSG_create_environment(platform_path);
+    recordShuffleTraffic(output->host, reducer->host, start_time, bytes);
+    return 1;
+}
+
+/** Shuffle Fetch Process: copies completed map outputs for its reducer */
+int shuffleFetch(int argc, char * argv[])
+{
+    int i;
+    struct HdmsgReducer *reducer = MSG_process_get_data(MSG_process_self());
+    struct HdmsgJob *job = reducer->job;
+    double bytes = get_bytes_to_shuffle(job, reducer->partition);
     
-    // Read config file and set parameters
-    FILE * config_file = fopen(config_path, "r");
+    struct HdmsgJobHost *job_host = get_job_host(job, reducer->host);
+    struct MapOutput output;
     
-    if (config_file == NULL)
+    // Fetchers start copying once their reducer has been launched
+    if (!job->reducers_launched)
     {
-        fprintf(stderr, "Error while opening config file.\n");
-        exit(1);
+        MSG_process_suspend(MSG_process_self());
+        simulation_events++;
     }
     
-    char line[256];
-    int number_of_masters = 0;
-    
-    hosts = xbt_dict_new();
-    host_attributes = xbt_dict_new();
-    
-    while (fgets(line, 256, config_file) != NULL)
+    while (1)
     {
-        line[strcspn(line, "\n")] = 0;
+        // Block until a map completes, or the fetcher that copied the last segment lets me go
+        MSG_sem_acquire(reducer->fetch_work);
+        simulation_events++;
         
-        if (strlen(line) > 0)
+        if (!take_map_output(reducer, &output))
         {
-            char *line_cpy = malloc(strlen(line) * sizeof(char));
-            strcpy(line_cpy, line);
-            
-            char *key = strsep(&line_cpy, " ");
-            char *value = strsep(&line_cpy, " ");
-            
-            if (strcmp(key, "master") == 0 || strcmp(key, "worker") == 0)
+            // Outputs lost to a crash are still to come from the maps run again
+            if (reducer->received_segments < reducer->expected_segments)
             {
-                char **hosts;
-                int hosts_length = 0;
-                
-                char *current_attributes = NULL;
-                char *new_attributes = NULL;
-                
-                if (strchr(value, '-') != NULL)
-                {
-                    char *host1 = strsep(&value, "-"); // returns first host in range
-                    char *host2 = strsep(&value, "-"); // returns last host in range
-                    
-                    char *prefix = malloc(strlen(host1) * sizeof(char));
-                    strcpy(prefix, host1);
-                    
-                    for (i = 0; i < strlen(prefix); i++)
-                    {
-                        prefix[i] = (isdigit(prefix[i])) ? '\0' : prefix[i];
-                    }
-                    
-                    int loopStart = atoi(&host1[strlen(prefix)]);
-                    int loopEnd = atoi(&host2[strlen(prefix)]);
-                    
-                    hosts_length = loopEnd - loopStart + 1;
-                    hosts = malloc((hosts_length) * sizeof(char *));
-                    
-                    for (i = 0; i < hosts_length; i++)
-                    {
-                        hosts[i] = malloc(strlen(host2) * sizeof(char));
-                        sprintf(hosts[i], "%s%d", prefix, loopStart + i);
-                    }
-                }
-                else
-                {
-                    hosts = malloc(sizeof(char *));
-                    hosts[0] = malloc(strlen(key) * sizeof(char));
-                    sprintf(hosts[0], "%s", value);
-                    hosts_length = 1;
-                }
-                
-                for (i = 0; i < hosts_length; i++)
-                {
-                    number_of_masters += (strcmp(key, "master") == 0) ? 1 : 0;
-                    number_of_workers += (strcmp(key, "worker") == 0) ? 1 : 0;
-                    
-                    current_attributes = xbt_dict_get_or_null(host_attributes, hosts[i]);
-                    
-                    if (current_attributes != NULL)
-                    {
-                        new_attributes = malloc((strlen(key) + strlen(current_attributes) + 2) * sizeof(char));
-                        strcat(new_attributes, current_attributes);
-                        strcat(new_attributes, " ");
-                    }
-                    else
-                    {
-                        new_attributes = malloc(strlen(hosts[i]) + sizeof(char));
-                    }
-                    
-                    strcat(new_attributes, key);
-                    xbt_dict_set(host_attributes, hosts[i], new_attributes, NULL);
-                }
-                
+                continue;
             }
-            else if (strcmp(key, "mappers") == 0)
-            {
-                if (isdigit(*value))
-                {
-                    mappers = atoi(value);
-                }
-            }
-            else if (strcmp(key, "reducers") == 0)
-            {
-                if (isdigit(*value))
-                {
-                    reducers = atoi(value);
-                }
-            }
-            else if (strcmp(key, "input_size_in_mb") == 0)
+            
+            break;
+        }
+        
+        // If this is the first copy, notify the master so the event is logged to the console
+        if (!job->shuffle_started)
+        {
+            job->shuffle_started = 1;
+            MSG_task_dsend(MSG_task_create("shuffle_start", 0, 1, NULL), job->mailbox, NULL);
+        }
+        
+        XBT_INFO("%s is starting a shuffle task", MSG_process_get_name(MSG_process_self()));
+        double start_time = MSG_get_clock();
+        
+        if (!fetch_map_output(reducer, &output, bytes))
+        {
+            continue;
+        }
+        
+        if (reducer->fetched_blocks != NULL)
+        {
+            reducer->fetched_blocks[output.block->block_id] = FETCH_DONE;
+        }
+        
+        XBT_INFO("%s has completed a shuffle task", MSG_process_get_name(MSG_process_self()));
+        segment_received(reducer, bytes);
+        METRICS_TASK(METRICS_SHUFFLE, start_time);
+        TRACE_SPAN("shuffle", "fetch", start_time, bytes);
+        
+        if (reducer->received_segments == reducer->expected_segments)
+        {
+            for (i = 1; i < xbt_fifo_size(reducer->receivers); i++)
             {
-                if (isdigit(*value))
-                {
-                    input_size = atol(value);
-                    input_size_bytes = input_size * BYTES_PER_MEGABYTE;
-                }
+                MSG_sem_release(reducer->fetch_work);
             }
-            else if (strcmp(key, "hdfs_chunk_size_in_mb") == 0)
+            break;
+        }
+    }
+    
+    // Notify master that I'm done working
+    notify_master(job, "shuffle_exit", &job_host->reported_shufflers);
+    
+    return 0;
+}
+
+/** Merges one copied segment into a pipelined reducer's input */
+static void merge_segment(struct HdmsgReducer *reducer)
+{
+    struct HdmsgJob *job = reducer->job;
+    double start_time = MSG_get_clock();
+    
+    execute_task("merge", get_merge_cost(MSG_host_self(), job, reducer->partition, reducer->expected_segments));
+    simulation_events++;
+    job->sim_reduce += MSG_get_clock() - start_time;
+    reducer->host->busy_time += MSG_get_clock() - start_time;
+    METRICS_BUSY(reducer->host, start_time);
+    TRACE_SPAN("reduce", "merge", start_time, 0);
+}
+
+/*
+ * Copies every map output again after a failed reduce attempt, as the next attempt starts
+ * with an empty input. An output whose host was lost comes from the map's next run.
+ */
+static void refetch_reduce_input(struct HdmsgReducer *reducer)
+{
+    long i;
+    struct HdmsgJob *job = reducer->job;
+    double bytes = get_bytes_to_shuffle(job, reducer->partition);
+    struct MapOutput output;
+    
+    reducer->received_segments = 0;
+    reducer->received_bytes = 0;
+    reducer->buffered_bytes = 0;
+    reducer->disk_bytes = 0;
+    reducer->disk_segments = 0;
+    
+    for (i = 0; i < job->map_tasks; i++)
+    {
+        output.block = job->blocks[i];
+        
+        do
+        {
+            while (!output.block->mapped || output.block->map_host->lost)
             {
-                if (isdigit(*value))
-                {
-                    hdfs_chunk_size = atoi(value);
-                    hdfs_chunk_size_bytes = hdfs_chunk_size * BYTES_PER_MEGABYTE;
-                }
+                MSG_sem_acquire(reducer->fetch_work);
+                simulation_events++;
             }
             
-            // Freeing 'key' works since 'key' will always point to the address returned by
-            // malloc whereas the value of line_cpy changes as a result of the call to strsep.
-            free(key);
+            output.host = output.block->map_host;
+        }
+        while (!fetch_map_output(reducer, &output, bytes));
+        
+        if (reducer->fetched_blocks != NULL)
+        {
+            reducer->fetched_blocks[output.block->block_id] = FETCH_DONE;
+        }
+        
+        segment_received(reducer, bytes);
+        
+        // Nobody waits for the segment, the attempt merges it itself
+        if (pipelined_reduce || pull_shuffle)
+        {
+            MSG_sem_acquire(reducer->merge_work);
+        }
+        
+        if (pipelined_reduce)
+        {
+            merge_segment(reducer);
         }
     }
+}
+
+/** Reduce Process */
+int reduce(int argc, char * argv[])
+{
+    long i;
+    double start_time;
+    struct HdmsgReducer *reducer = MSG_process_get_data(MSG_process_self());
+    struct HdmsgJob *job = reducer->job;
+    double reduce_cost = get_reduce_cost(MSG_host_self(), job, reducer->partition);
     
-    fclose(config_file);
+    // Wait for the reduce phase to begin, unless this reducer replaces one lost to a crash
+    if (!job->reducers_launched)
+    {
+        MSG_process_suspend(MSG_process_self());
+        simulation_events++;
+    }
     
-    // Must have exactly one master process
-    if (number_of_masters != 1)
+    allocate_container(reducer->host, CONTAINER_REDUCE, job);
+    
+    if (pipelined_reduce)
+    {
+        // Merge each segment as soon as a receiver has copied it
+        for (i = 0; i < reducer->expected_segments; i++)
+        {
+            MSG_sem_acquire(reducer->merge_work);
+            simulation_events++;
+            merge_segment(reducer);
+        }
+        
+        // What is left of the reduce runs once every segment has been merged
+        reduce_cost *= (1 - reduce_merge_fraction);
+    }
+    else if (pull_shuffle)
     {
-        fprintf(stderr, "There must be exactly one master process.\n");
+        // Wait for the fetchers to copy every segment
+        for (i = 0; i < reducer->expected_segments; i++)
+        {
+            MSG_sem_acquire(reducer->merge_work);
+            simulation_events++;
+        }
+    }
+    
+    XBT_INFO("%s is starting a reduce task", MSG_process_get_name(MSG_process_self()));
+    start_time = MSG_get_clock();
+    
+    // A failed attempt wastes part of the task, and the next attempt copies its input again
+    while (failAttempt(job, reducer->host, reduce_cost, "reduce"))
+    {
+        retryReduceTask(reducer);
+        refetch_reduce_input(reducer);
+    }
+    
+    mergeReduceInput(reducer->host, reducer->disk_bytes, reducer->disk_segments);
+    executeReduceTask(reducer, reduce_cost);
+    writeReduceOutput(reducer->host, reducer->received_bytes / compression_ratio);
+    job->sim_reduce += MSG_get_clock() - start_time;
+    reducer->host->busy_time += MSG_get_clock() - start_time;
+    reducer->finish_time = MSG_get_clock();
+    release_container(reducer->host, CONTAINER_REDUCE, job);
+    METRICS_BUSY(reducer->host, start_time);
+    METRICS_TASK(METRICS_REDUCE, start_time);
+    TRACE_SPAN("reduce", "reduce", start_time, reducer->received_bytes);
+    XBT_INFO("%s has completed a reduce task", MSG_process_get_name(MSG_process_self()));
+    
+    // Notify the master that I'm done working
+    notify_master(job, "reduce_exit", &get_job_host(job, reducer->host)->reported_reducers);
+    
+    return 0;
+}
+
+/** Main function */
+int main(int argc, char *argv[])
+{
+    char *mode = NULL;
+    char *config_path;
+    char *platform_path;
+    
+    MSG_init(&argc, argv);
+    
+    // An optional mode flag comes before the usual arguments
+    int first_arg = 1;
+    if (argc > 1 && strncmp(argv[1], "--", 2) == 0)
+    {
+        mode = argv[1];
+        first_arg = 2;
+    }
+    
+    // Modes that simulate one pair of calibration factors take them on the command line
+    int takes_factors = (mode == NULL ||
+                         strcmp(mode, "--analytic") == 0 ||
+                         strcmp(mode, "--workload") == 0 ||
+                         strcmp(mode, "--replicate") == 0 ||
+                         strcmp(mode, "--replicate-all") == 0 ||
+                         strcmp(mode, "--failures") == 0);
+    int known_mode = (mode == NULL ||
+                      strcmp(mode, "--sweep") == 0 ||
+                      strcmp(mode, "--calibrate") == 0 ||
+                      strcmp(mode, "--calibrate-all") == 0 ||
+                      strcmp(mode, "--analytic") == 0 ||
+                      strcmp(mode, "--workload") == 0 ||
+                      strcmp(mode, "--replicate") == 0 ||
+                      strcmp(mode, "--replicate-all") == 0 ||
+                      strcmp(mode, "--failures") == 0);
+    
+    if (!known_mode || argc != first_arg + (takes_factors ? 4 : 2))
+    {
+        printf("Usage: %s map_cf reduce_cf config platform.xml\n", argv[0]);
+        printf("       %s --sweep config platform.xml\n", argv[0]);
+        printf("       %s --calibrate config platform.xml\n", argv[0]);
+        printf("       %s --calibrate-all config platform.xml\n", argv[0]);
+        printf("       %s --analytic map_cf reduce_cf config platform.xml\n", argv[0]);
+        printf("       %s --workload map_cf reduce_cf config platform.xml\n", argv[0]);
+        printf("       %s --replicate map_cf reduce_cf config platform.xml\n", argv[0]);
+        printf("       %s --replicate-all map_cf reduce_cf config platform.xml\n", argv[0]);
+        printf("       %s --failures map_cf reduce_cf config platform.xml\n", argv[0]);
+        printf("Example: %s 0.28 0.29 path_to_config path_to_platform.xml \n", argv[0]);
         exit(1);
     }
     
+    if (takes_factors)
+    {
+        // Set calibration factors
+        sscanf(argv[first_arg], "%lf", &MAP_CALIBRATION_FACTOR);
+        sscanf(argv[first_arg + 1], "%lf", &REDUCE_CALIBRATION_FACTOR);
+        first_arg += 2;
+    }
+    
+    // Set file paths
+    config_path = argv[first_arg];
+    platform_path = argv[first_arg + 1];
+    
+    // Register the functions
+    MSG_function_register("master", master);
+    MSG_function_register("initializeProcs", initializeProcs);
+    
+    MSG_function_register("map", map);
+    MSG_function_register("reduce", reduce);
+    
+    MSG_function_register("shuffleSend", shuffleSend);
+    MSG_function_register("hdfsServeBlock", hdfsServeBlock);
+    MSG_function_register("speculator", speculator);
+    MSG_function_register("speculativeAttempt", speculativeAttempt);
+    MSG_function_register("failureInjector", failureInjector);
+    MSG_function_register("workloadSubmitter", workloadSubmitter);
+    MSG_function_register("workloadSampler", workloadSampler);
+    MSG_function_register("shuffleReceive", shuffleReceive);
+    MSG_function_register("shuffleFetch", shuffleFetch);
+    
+    // Create the environment
+    MSG_create_environment(platform_path);
+    
+    // The platform and config are parsed once. Sweep workers are forked afterwards and inherit both.
+    readConfig(config_path, mode);
+    createHdmsgHosts();
+    loadGroundTruth(platform_path);
+    
+    if (mode != NULL && strcmp(mode, "--sweep") == 0)
+    {
+        return runSweep();
+    }
+    else if (mode != NULL && strcmp(mode, "--analytic") == 0)
+    {
+        return runAnalytic(MAP_CALIBRATION_FACTOR, REDUCE_CALIBRATION_FACTOR);
+    }
+    else if (mode != NULL && strcmp(mode, "--workload") == 0)
+    {
+        return runWorkload(MAP_CALIBRATION_FACTOR, REDUCE_CALIBRATION_FACTOR);
+    }
+    else if (mode != NULL && strncmp(mode, "--replicate", 11) == 0)
+    {
+        return runReplications(strcmp(mode, "--replicate-all") == 0, MAP_CALIBRATION_FACTOR, REDUCE_CALIBRATION_FACTOR);
+    }
+    else if (mode != NULL && strcmp(mode, "--failures") == 0)
+    {
+        return runFailures(MAP_CALIBRATION_FACTOR, REDUCE_CALIBRATION_FACTOR);
+    }
+    else if (mode != NULL)
+    {
+        return runCalibration(strcmp(mode, "--calibrate-all") == 0);
+    }
+    
+    struct SimResult result;
+    initSimResult(&result, MAP_CALIBRATION_FACTOR, REDUCE_CALIBRATION_FACTOR);
+    
+    openTrace();
+    openMetrics();
+    runSimulation(&result);
+    closeMetrics();
+    closeTrace();
+    
+    // Per-reducer bytes and finish times, to see which reducers the key distribution made stragglers
+    if (strcmp(key_distribution, "uniform") != 0)
+    {
+        FILE * reducer_file = fopen("HDMSG_reducers.txt", "w");
+        writeReducerReport(reducer_file, simulated_job);
+        fclose(reducer_file);
+        
+        writeReducerReport(stdout, simulated_job);
+    }
+    
+    // If I don't have actual execution times, then don't print stats just exit.
+    if (!result.has_actual) { return result.status; }
+    
+    // Write results to file
+    FILE * output_file = NULL;
+    output_file = fopen("HDMSG_output.txt", "a");
+    writeSimResult(output_file, &result);
+    fclose(output_file);
+    
+    // Write results to the console
+    printf("\n\t\tMap Phase\t\tReduce Phase\t\tExecution Time\t\tSimulation Error\t\tAvg Percent Diff\n");
+    printf("Actual: %17.2f %26.2f %25.2f\n", result.actual_map, result.actual_reduce, result.actual_exec);
+    printf("Simulated: %14.2f %26.2f %25.2f %24.2f%% %24.2f%%\n\n",
+           result.sim_map,
+           result.sim_reduce,
+           result.simulation_time,
+           result.sim_err,
+           result.avg_percent_diff);
+    
+    return result.status;
+    
+}   /* end_of_main */
+
+/** Associate each configured host with its msg_host_t */
+void createHdmsgHosts()
+{
     xbt_dynar_t host_dynar = MSG_hosts_as_dynar();
     number_of_hosts = (int) xbt_dynar_length(host_dynar);
     
@@ -578,18 +1172,22 @@ int main(int argc, char *argv[])
     unsigned int cpt;
     msg_host_t dyn_host;
     
+    hosts = xbt_dict_new();
+    number_of_workers = 0;
+    
     xbt_dynar_foreach (host_dynar, cpt, dyn_host)
     {
-        char *attributes = xbt_dict_get_or_null(host_attributes, MSG_host_get_name(dyn_host));
+        int roles = match_host_roles(MSG_host_get_name(dyn_host));
         
-        if (attributes != NULL)
+        if (roles != 0)
         {
-            struct HdmsgHost *hdmsg_host = newHdmsgHost(0, dyn_host, attributes);
+            struct HdmsgHost *hdmsg_host = newHdmsgHost(0, dyn_host, roles);
+            number_of_workers += hdmsg_host->is_worker;
             
             if (hdmsg_host->is_master)
             {
                 hdmsg_host->host_id = 0;
-                MSG_process_create("master", master, NULL, hdmsg_host->host);
+                master_host = hdmsg_host;
             }
             else
             {
@@ -598,201 +1196,416 @@ int main(int argc, char *argv[])
             }
             
             xbt_dict_set(hosts, hdmsg_host->host_name, hdmsg_host, (void *)destroyHdmsgHost);
+            registerHdmsgHost(hdmsg_host);
         }
     }
     
-    // TODO: Should I ensure that each hdmsg_host has an msg_host_t?
-    
-    distributeHdfsChunks();
+    // Every host the config names must be in the platform
+    checkHostRanges();
     
-    res = MSG_main();
-    
-    double simulation_time = MSG_get_clock();
-    XBT_INFO("Simulation time %g", simulation_time);
-    
-    sim_map /= (input_size_bytes / hdfs_chunk_size_bytes); // (input_size_bytes / hdfs_chunk_size_bytes) = number of map tasks
-    sim_reduce /= reducers;
-    
-    int iX, iY, iZ;
-    iX = log2(input_size) - 8;
-    iY = log2(hdfs_chunk_size) - 5;
-    iZ = log2(reducers) - 2;
-    
-    // If I don't have actual execution times, then don't print stats just exit.
-    if (iX >= 3 || iY >= 3 || iZ >= 3) { return (res == MSG_OK) ? 0 : 1; }
-    
-    double mapTimes[3][3][3];  // Input size (256, 512, 1024), Chunk size (32, 64, 128), Number of reducers (4, 8, 16)
-    
-    /*  256  */
-    mapTimes[0][0][0] = 399; // 256-32-4
-    mapTimes[0][0][1] = 391;  // 256-32-8
-    mapTimes[0][0][2] = 385;  // 256-32-16
-    
-    mapTimes[0][1][0] = 830; // 256-64-4
-    mapTimes[0][1][1] = 815;  // 256-64-8
-    mapTimes[0][1][2] = 801;  // 256-64-16
-    
-    /*  512 */
-    mapTimes[0][0][0] = 399; // 256-32-4
-    mapTimes[0][0][1] = 391;  // 256-32-8
-    mapTimes[0][0][2] = 385;  // 256-32-16
+    assignRacks();
+    assignContainerResources();
+    assignDiskBandwidths();
+}
+
+/** Run one simulation with the calibration factors in result, and fill in the rest of result */
+void runSimulation(struct SimResult *result)
+{
+    msg_error_t res = MSG_OK;
     
-    mapTimes[1][0][0] = 438; // 512-32-4
-    mapTimes[1][0][1] = 432;  // 512-32-8
-    mapTimes[1][0][2] = 425;  // 512-32-16
+    MAP_CALIBRATION_FACTOR = result->map_calibration_factor;
+    REDUCE_CALIBRATION_FACTOR = result->reduce_calibration_factor;
     
-    mapTimes[1][1][0] = 833; // 512-64-4
-    mapTimes[1][1][1] = 821; // 512-64-8
-    mapTimes[1][1][2] = 809; // 512-64-16
+    input_size = result->input_size;
+    input_size_bytes = input_size * BYTES_PER_MEGABYTE;
+    hdfs_chunk_size = result->hdfs_chunk_size;
+    hdfs_chunk_size_bytes = hdfs_chunk_size * BYTES_PER_MEGABYTE;
+    reducers = result->reducers;
     
-    mapTimes[1][2][0] = 1638; // 512-128-4
-    mapTimes[1][2][1] = 1616; // 512-128-8
-    mapTimes[1][2][2] = 998; // 512-128-16
+    struct HdmsgJob *job = newHdmsgJob(0, NULL, input_size, hdfs_chunk_size, reducers);
+    unfinished_jobs = 1;
+    simulated_job = job;
     
+    MSG_process_create("master", master, job, master_host->host);
     
-    double reduceTimes[3][3][3];
+    seedRandom(result->seed);
+    memset(map_locality, 0, sizeof(map_locality));
+    distributeHdfsChunks(job);
+    chooseStragglerHosts();
+    scheduleFailures(result->failure_scenario);
     
-    /*  256  */
-    reduceTimes[0][0][0] = 334; // 256-32-4
-    reduceTimes[0][0][1] = 168;  // 256-32-8
-    reduceTimes[0][0][2] = 91;  // 256-32-16
+    res = MSG_main();
     
-    reduceTimes[0][1][0] = 334; // 256-64-4
-    reduceTimes[0][1][1] = 171;  // 256-64-8
-    reduceTimes[0][1][2] = 90;  // 256-64-16
+    double simulation_time = MSG_get_clock();
+    XBT_INFO("Simulation time %g", simulation_time);
+    XBT_INFO("Simulation events %ld", simulation_events);
+    XBT_INFO("Simulation processes %d at most", peak_processes);
+    XBT_INFO("Map locality: %ld node-local, %ld rack-local, %ld remote",
+             map_locality[HDFS_NODE_LOCAL], map_locality[HDFS_RACK_LOCAL], map_locality[HDFS_REMOTE]);
+    logShuffleTraffic();
     
-    /*  512 */
-    reduceTimes[0][0][0] = 334; // 256-32-4
-    reduceTimes[0][0][1] = 168;  // 256-32-8
-    reduceTimes[0][0][2] = 91;  // 256-32-16
+    // Busy time is the sum of the task durations on a host, so it counts each busy core
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
     
-    reduceTimes[1][0][0] = 672; // 512-32-4
-    reduceTimes[1][0][1] = 338;  // 512-32-8
-    reduceTimes[1][0][2] = 187;  // 512-32-16
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            long cores = MSG_host_get_core_number(hdmsg_host->host);
+            XBT_INFO("%s busy %.2f core-seconds, %.1f%% of its %ld cores",
+                     hdmsg_host->host_name,
+                     hdmsg_host->busy_time,
+                     100 * hdmsg_host->busy_time / (cores * simulation_time),
+                     cores);
+        }
+    }
     
-    reduceTimes[1][1][0] = 664; // 512-64-4
-    reduceTimes[1][1][1] = 342; // 512-64-8
-    reduceTimes[1][1][2] = 184; // 512-64-16
+    if (work_stealing)
+    {
+        XBT_INFO("Stolen map tasks %ld", stolen_maps);
+    }
     
-    reduceTimes[1][2][0] = 667; // 512-128-4
-    reduceTimes[1][2][1] = 338; // 512-128-8
-    reduceTimes[1][2][2] = 183; // 512-128-16
+    if (containers_enabled())
+    {
+        logContainerReport();
+    }
     
+    if (disk_enabled())
+    {
+        logDiskReport();
+    }
     
-    double actualTimes[3][3][3];
+    if (speculative_execution)
+    {
+        logSpeculationReport();
+    }
     
-    /*  256  */
-    actualTimes[0][0][0] = 773; // 256-32-4
-    actualTimes[0][0][1] = 600;  // 256-32-8
-    actualTimes[0][0][2] = 527;  // 256-32-16
+    if (failures_enabled())
+    {
+        logFailureReport(&failure_stats);
+    }
     
-    actualTimes[0][1][0] = 1216; // 256-64-4
-    actualTimes[0][1][1] = 1035;  // 256-64-8
-    actualTimes[0][1][2] = 947;  // 256-64-16
+    result->sim_map = job->sim_map / job->map_tasks;
+    result->sim_reduce = job->sim_reduce / reducers;
+    result->simulation_time = simulation_time;
+    result->events = simulation_events;
+    result->node_local_maps = map_locality[HDFS_NODE_LOCAL];
+    result->rack_local_maps = map_locality[HDFS_RACK_LOCAL];
+    result->remote_maps = map_locality[HDFS_REMOTE];
+    result->failures = failure_stats;
+    result->status = (res == MSG_OK && !failure_stats.job_failed) ? 0 : 1;
+    
+    compareToActual(result);
+}
+
+/** Fill in the measured cluster times for this configuration, if there are any */
+void compareToActual(struct SimResult *result)
+{
+    result->has_actual = getActualTimes(result->input_size,
+                                        result->hdfs_chunk_size,
+                                        result->reducers,
+                                        &result->actual_map,
+                                        &result->actual_reduce,
+                                        &result->actual_exec);
     
-    /*  512 */
-    actualTimes[0][0][0] = 773; // 256-32-4
-    actualTimes[0][0][1] = 600;  // 256-32-8
-    actualTimes[0][0][2] = 527;  // 256-32-16
+    if (!result->has_actual) { return; }
     
-    actualTimes[1][0][0] = 1172; // 512-32-4
-    actualTimes[1][0][1] = 833;  // 512-32-8
-    actualTimes[1][0][2] = 682;  // 512-32-16
+    result->sum_of_diffs = 100 * fabs(result->sim_map - result->actual_map)/result->actual_map +
+                           100 * fabs(result->sim_reduce - result->actual_reduce)/result->actual_reduce;
+    result->avg_percent_diff = result->sum_of_diffs / 2;
     
-    actualTimes[1][1][0] = 1562; // 512-64-4
-    actualTimes[1][1][1] = 1221; // 512-64-8
-    actualTimes[1][1][2] = 1126; // 512-64-16
+    result->sim_err = (fabs(result->simulation_time - result->actual_exec) / result->actual_exec) * 100;
+}
+
+/** Set up result to simulate the configured job with the given calibration factors */
+void initSimResult(struct SimResult *result, double map_cf, double reduce_cf)
+{
+    memset(result, 0, sizeof(struct SimResult));
     
-    actualTimes[1][2][0] = 2237; // 512-128-4
-    actualTimes[1][2][1] = 2031; // 512-128-8
-    actualTimes[1][2][2] = 1851; // 512-128-16
+    result->map_calibration_factor = map_cf;
+    result->reduce_calibration_factor = reduce_cf;
+    result->input_size = input_size;
+    result->hdfs_chunk_size = hdfs_chunk_size;
+    result->reducers = reducers;
+    result->seed = random_seed;
     
-    double actual_map = mapTimes[iX][iY][iZ];
-    double actual_reduce = reduceTimes[iX][iY][iZ];
-    double actual_exec = actualTimes[iX][iY][iZ];
+    // The configured failures, if any, are injected into the run
+    result->failure_scenario = 1;
+}
+
+/** Write one line of results in the HDMSG_output.txt format */
+void writeSimResult(FILE *output_file, struct SimResult *result)
+{
+    fprintf(output_file, "%.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f\n",
+            result->map_calibration_factor,
+            result->reduce_calibration_factor,
+            result->sim_map,
+            result->actual_map,
+            result->sim_reduce,
+            result->actual_reduce,
+            result->simulation_time,
+            result->actual_exec,
+            result->sim_err,
+            result->sum_of_diffs,
+            result->avg_percent_diff);
+}
+
+
+
+/*
+ * Counts a completed map task. The one that crosses the slow-start threshold has the
+ * master launch the reducers.
+ */
+void map_completed(struct HdmsgJob *job)
+{
+    job->completed_maps++;
     
-    double sum_of_diffs = 100 * fabs(sim_map - actual_map)/actual_map + 100 * fabs(sim_reduce - actual_reduce)/actual_reduce;
-    double avg_percent_diff = sum_of_diffs / 2;
+    if (pipelined_reduce && !job->reduce_started &&
+        job->completed_maps >= reduce_slowstart * job->map_tasks)
+    {
+        job->reduce_started = 1;
+        MSG_task_dsend(MSG_task_create("reduce_start", 0, 1, NULL), job->mailbox, NULL);
+    }
+}
+
+/*
+ * Counts a shuffle segment copied to a reducer: keeps it in memory or on disk, decompresses
+ * it, and hands it to the reducer when the reducer merges or waits for segments itself.
+ */
+void segment_received(struct HdmsgReducer *reducer, double bytes)
+{
+    reducer->received_bytes += bytes;
+    bufferShuffleSegment(reducer->host, &reducer->buffered_bytes, &reducer->disk_bytes, &reducer->disk_segments, bytes);
     
-    double sim_err = (fabs(simulation_time - actual_exec) / actual_exec) * 100;
+    if (decompress_cost_per_mb > 0)
+    {
+        double start_time = MSG_get_clock();
+        execute_task("decompress", get_decompress_cost(MSG_host_self(), bytes));
+        simulation_events++;
+        reducer->host->busy_time += MSG_get_clock() - start_time;
+        METRICS_BUSY(reducer->host, start_time);
+    }
     
-    // Write results to file
-    FILE * output_file = NULL;
-    output_file = fopen("HDMSG_output.txt", "a");
+    reducer->received_segments++;
     
-    fprintf(output_file, "%.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f %.2f\n",
-            MAP_CALIBRATION_FACTOR,
-            REDUCE_CALIBRATION_FACTOR,
-            sim_map,
-            actual_map,
-            sim_reduce,
-            actual_reduce,
-            simulation_time,
-            actual_exec,
-            sim_err,
-            sum_of_diffs,
-            avg_percent_diff);
+    if (pipelined_reduce || pull_shuffle)
+    {
+        MSG_sem_release(reducer->merge_work);
+    }
+}
+
+/*
+ * Sends a process's exit message to its job's master, again if a link failure cuts it off,
+ * and counts it on the process's host once it got through
+ */
+void notify_master(struct HdmsgJob *job, const char *name, long *reported)
+{
+    while (1)
+    {
+        msg_task_t task = MSG_task_create(name, 0, 1, NULL);
+        msg_comm_t comm = MSG_task_isend(task, job->mailbox);
+        msg_error_t res = MSG_comm_wait(comm, -1);
+        MSG_comm_destroy(comm);
+        simulation_events++;
+        
+        if (res == MSG_OK)
+        {
+            break;
+        }
+        
+        MSG_task_destroy(task);
+        waitToRetry();
+    }
     
-    fclose(output_file);
+    (*reported)++;
+}
+
+/*
+ * Returns the speed task costs are scaled by. By default a cost takes the same time on
+ * every host. With heterogeneous_speeds, costs are measured on the fastest worker and
+ * slower workers take proportionally longer.
+ */
+double get_reference_speed(msg_host_t h)
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
     
-    // Write results to the console
-    printf("\n\t\tMap Phase\t\tReduce Phase\t\tExecution Time\t\tSimulation Error\t\tAvg Percent Diff\n");
-    printf("Actual: %17.2f %26.2f %25.2f\n", actual_map, actual_reduce, actual_exec);
-    printf("Simulated: %14.2f %26.2f %25.2f %24.2f%% %24.2f%%\n\n", sim_map, sim_reduce, simulation_time, sim_err, avg_percent_diff);
+    if (!heterogeneous_speeds)
+    {
+        return MSG_host_get_speed(h);
+    }
     
-    return (res == MSG_OK) ? 0 : 1;
+    if (reference_speed == 0)
+    {
+        xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+        {
+            if (hdmsg_host->is_worker && MSG_host_get_speed(hdmsg_host->host) > reference_speed)
+            {
+                reference_speed = MSG_host_get_speed(hdmsg_host->host);
+            }
+        }
+    }
     
-}   /* end_of_main */
-
-
+    return reference_speed;
+}
 
 double get_initialization_cost(msg_host_t h)
 {
     double INIT_CALIBRATION_FACTOR = 35;
-    return INIT_CALIBRATION_FACTOR * MSG_host_get_speed(h);
+    return INIT_CALIBRATION_FACTOR * get_reference_speed(h);
 }
 
 /*
- * Returns the cost of the map task in flops
+ * Returns the cost of a map task of a job in flops
  */
-double get_map_cost(msg_host_t h)
+double get_map_cost(msg_host_t h, struct HdmsgJob *job)
+{
+    return get_chunk_map_cost(h, job->hdfs_chunk_size);
+}
+
+/*
+ * Returns the cost of a map task over a chunk of the given size in MB, in flops
+ */
+double get_chunk_map_cost(msg_host_t h, double chunk_mb)
 {
     double flops_per_mb = 13.6;
-    return MAP_CALIBRATION_FACTOR * hdfs_chunk_size * flops_per_mb * MSG_host_get_speed(h);
+    return MAP_CALIBRATION_FACTOR * chunk_mb * flops_per_mb * get_reference_speed(h);
 }
 
-double get_bytes_to_shuffle()
+/*
+ * Returns the bytes of one of a job's map task outputs that belong to a partition
+ */
+double get_bytes_to_shuffle(struct HdmsgJob *job, long partition)
 {
-    return (hdfs_chunk_size_bytes / reducers);
+    return (job->hdfs_chunk_size_bytes * combiner_ratio * compression_ratio * get_reducer_share(job, partition));
 }
 
-double get_reduce_cost(msg_host_t h)
+/*
+ * Returns the cost of the reduce task of a job's partition in flops
+ */
+double get_reduce_cost(msg_host_t h, struct HdmsgJob *job, long partition)
+{
+    return get_partition_reduce_cost(h, job->input_size * combiner_ratio * get_reducer_share(job, partition));
+}
+
+/*
+ * Returns the cost of reducing a partition of the given size in MB, in flops
+ */
+double get_partition_reduce_cost(msg_host_t h, double partition_mb)
 {
     double flops_per_mb = 5.25;
-    return REDUCE_CALIBRATION_FACTOR * (input_size / reducers) * flops_per_mb * MSG_host_get_speed(h);
+    return REDUCE_CALIBRATION_FACTOR * partition_mb * flops_per_mb * get_reference_speed(h);
 }
 
+/*
+ * Returns the cost of merging one of a pipelined reducer's segments in flops
+ */
+double get_merge_cost(msg_host_t h, struct HdmsgJob *job, long partition, long segments)
+{
+    return reduce_merge_fraction * get_reduce_cost(h, job, partition) / segments;
+}
 
-void distributeHdfsChunks()
+/*
+ * Returns the cost of compressing the combined output of one of a job's map tasks in flops
+ */
+double get_compress_cost(msg_host_t h, struct HdmsgJob *job)
 {
-    char * key;
+    return get_chunk_compress_cost(h, job->hdfs_chunk_size);
+}
+
+/*
+ * Returns the cost of compressing the combined output of a chunk of the given size in MB, in flops
+ */
+double get_chunk_compress_cost(msg_host_t h, double chunk_mb)
+{
+    return chunk_mb * combiner_ratio * compress_cost_per_mb * get_reference_speed(h);
+}
+
+/*
+ * Returns the cost of decompressing a shuffle segment of the given compressed size in flops
+ */
+double get_decompress_cost(msg_host_t h, double bytes)
+{
+    return (bytes / compression_ratio / BYTES_PER_MEGABYTE) * decompress_cost_per_mb * get_reference_speed(h);
+}
+
+
+/*
+ * Splits a job's reducers over the workers by their share of the reduce capacity. Each worker
+ * gets the whole part of its share, and the reducers left over go to the largest remainders,
+ * in host_id order on ties.
+ */
+static void apportion_reducers(struct HdmsgJob *job)
+{
+    int i;
     struct HdmsgHost * hdmsg_host;
-    xbt_dict_cursor_t cursor = NULL;
+    double total_capacity = 0;
+    long apportioned = 0;
+    long *reducer_quotas = xbt_new0(long, host_table_size);
+    double *remainders = xbt_new0(double, host_table_size);
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            total_capacity += get_capacity(hdmsg_host, get_container_capacity(hdmsg_host, CONTAINER_REDUCE));
+        }
+    }
     
-    long number_of_input_chunks = input_size_bytes / hdfs_chunk_size_bytes;
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            double share = job->reducers * get_capacity(hdmsg_host, get_container_capacity(hdmsg_host, CONTAINER_REDUCE)) / total_capacity;
+            reducer_quotas[i] = floor(share);
+            remainders[i] = share - reducer_quotas[i];
+            apportioned += reducer_quotas[i];
+        }
+    }
     
-    while (number_of_input_chunks > 0)
+    while (apportioned < job->reducers)
     {
-        xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+        int largest = -1;
+        
+        foreach_hdmsg_host(i, hdmsg_host)
         {
-            if (number_of_input_chunks > 0 && hdmsg_host->is_worker)
+            if (hdmsg_host->is_worker && (largest < 0 || remainders[i] > remainders[largest]))
             {
-                add_map_task(hdmsg_host, get_map_cost(hdmsg_host->host));
-                number_of_input_chunks--;
+                largest = i;
             }
         }
+        
+        reducer_quotas[largest]++;
+        remainders[largest] = -1;
+        apportioned++;
     }
     
+    job->reducer_quotas = reducer_quotas;
+    free(remainders);
+}
+
+/*
+ * Returns the number of a job's reducers that run on a worker, by its share of the reduce capacity
+ */
+long get_reducers_to_launch(struct HdmsgJob *job, struct HdmsgHost *this_host)
+{
+    if (job->reducer_quotas == NULL)
+    {
+        apportion_reducers(job);
+    }
+    
+    return job->reducer_quotas[this_host->host_id];
+}
+
+/** Places a job's input blocks and schedules a map task for each */
+void distributeHdfsChunks(struct HdmsgJob *job)
+{
+    // The blocks are kept for the maps a crash makes run again
+    job->blocks = placeHdfsBlocks(job->map_tasks);
+    scheduleHdfsBlocks(job);
 }
 
 double Log2(double n)
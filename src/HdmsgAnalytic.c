@@ -0,0 +1,368 @@
+//
+//  HdmsgAnalytic.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include "HdmsgAnalytic.h"
+#include "HdmsgSkew.h"
+#include "HdmsgHdfs.h"
+#include "HdmsgRandom.h"
+#include "HdmsgYarn.h"
+
+// The analytic model cannot query link properties from the platform, so they are given here.
+// The defaults match picluster.xml: bw="90MBps" lat="75ms" on every host link.
+double analytic_bandwidth = 90;     // In MB/s (10^6 bytes, as in SimGrid)
+double analytic_latency = 75;       // In ms, per link
+int analytic_validate = 0;          // Also run the full simulation and report the difference
+char *analytic_batch_file = NULL;   // Configurations to estimate, one per line
+
+/** Returns the tasks of a type a host runs at once: one per core, or per container when fewer fit */
+static long get_analytic_slots(struct HdmsgHost *this_host, int type)
+{
+    return fmin(get_container_capacity(this_host, type), MSG_host_get_core_number(this_host->host));
+}
+
+/*
+ * Predicts sim_map, sim_reduce and the total simulated time without running MSG_main().
+ *
+ * The model follows the simulation phase by phase. Mappers on each host run their host's
+ * chunks in waves of one task per core. Each link carries the shuffle bytes leaving and
+ * entering its host, and the output of the last map wave has to cross it after the map
+ * phase. Reducers start together and share their host's cores, and the largest partition
+ * of the key distribution sets the length of the reduce phase.
+ *
+ * distributeHdfsChunks() must already have run on the job with the same calibration factors,
+ * so the model sees exactly the chunk placement the simulation would. Workers without a slot
+ * are left out. The status is 1 if no worker has a map slot or none has a reduce slot.
+ */
+void estimateAnalytic(struct HdmsgJob *job, struct SimResult *result)
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    struct HdmsgHost * other_host;
+    xbt_dict_cursor_t cursor = NULL;
+    xbt_dict_cursor_t other_cursor = NULL;
+    
+    double bandwidth = analytic_bandwidth * 1e6;
+    double message_latency = 2 * analytic_latency / 1000;   // Every route crosses two host links
+    
+    double init_end = 0;
+    double map_end = 0;
+    double shuffle_end = 0;
+    double reduce_duration = 0;
+    double total_map_time = 0;
+    double total_reduce_time = 0;
+    long total_chunks = 0;
+    int map_hosts = 0;
+    int reduce_hosts = 0;
+    
+    // Initialization: every worker starts its processes, then notifies the master
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            init_end = fmax(init_end, get_initialization_cost(hdmsg_host->host) / MSG_host_get_speed(hdmsg_host->host));
+        }
+    }
+    init_end += message_latency;
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (!hdmsg_host->is_worker)
+        {
+            continue;
+        }
+        
+        long map_slots = get_analytic_slots(hdmsg_host, CONTAINER_MAP);
+        long reduce_slots = get_analytic_slots(hdmsg_host, CONTAINER_REDUCE);
+        
+        // A worker no container fits on runs nothing
+        if (map_slots == 0 && reduce_slots == 0)
+        {
+            continue;
+        }
+        
+        map_hosts += (map_slots > 0);
+        reduce_hosts += (reduce_slots > 0);
+        
+        // Map: waves of one task per core, or per map container when fewer fit
+        long chunks = xbt_fifo_size(get_job_host(job, hdmsg_host)->map_tasks);
+        long cores = MSG_host_get_core_number(hdmsg_host->host);
+        double map_duration = (get_map_cost(hdmsg_host->host, job) + get_compress_cost(hdmsg_host->host, job)) / MSG_host_get_speed(hdmsg_host->host);
+        long waves = (map_slots > 0) ? (chunks + map_slots - 1) / map_slots : 0;
+        long last_wave = (waves > 0) ? chunks - (waves - 1) * map_slots : 0;
+        double host_map_end = init_end + waves * map_duration;
+        
+        // Remote block reads share the host's link ahead of their maps
+        host_map_end += get_remote_map_count(get_job_host(job, hdmsg_host)) * job->hdfs_chunk_size_bytes / bandwidth;
+        
+        map_end = fmax(map_end, host_map_end);
+        total_map_time += chunks * map_duration;
+        total_chunks += chunks;
+        
+        // Shuffle: bytes this host sends to and receives from the others, over its one link
+        long host_reducers = get_reducers_to_launch(job, hdmsg_host);
+        double remote_fraction = (double) (job->reducers - host_reducers) / job->reducers;
+        double output_bytes = job->hdfs_chunk_size_bytes * combiner_ratio * compression_ratio;
+        double link_bytes = chunks * output_bytes * remote_fraction;
+        double last_wave_bytes = last_wave * output_bytes * remote_fraction;
+        double last_wave_in_bytes = 0;
+        
+        xbt_dict_foreach(hosts, other_cursor, key, other_host)
+        {
+            if (other_host->is_worker && other_host != hdmsg_host)
+            {
+                long other_chunks = xbt_fifo_size(get_job_host(job, other_host)->map_tasks);
+                long other_slots = get_analytic_slots(other_host, CONTAINER_MAP);
+                long other_waves = (other_slots > 0) ? (other_chunks + other_slots - 1) / other_slots : 0;
+                long other_last_wave = (other_waves > 0) ? other_chunks - (other_waves - 1) * other_slots : 0;
+                
+                link_bytes += other_chunks * output_bytes * ((double) host_reducers / job->reducers);
+                last_wave_in_bytes += other_last_wave * output_bytes * ((double) host_reducers / job->reducers);
+            }
+        }
+        last_wave_bytes += last_wave_in_bytes;
+        
+        // Decompressing the last wave's segments on this host's cores follows their arrival
+        double decompress_duration = get_decompress_cost(hdmsg_host->host, last_wave_in_bytes) / MSG_host_get_speed(hdmsg_host->host);
+        decompress_duration /= fmin(cores, fmax(1, host_reducers * SHUFFLE_RECEIVERS_PER_REDUCER));
+        
+        // Either the whole volume saturates the link, or the last wave's output is what is left after the maps
+        double host_shuffle_end = fmax(host_map_end + last_wave_bytes / bandwidth,
+                                       init_end + map_duration + link_bytes / bandwidth) + decompress_duration;
+        shuffle_end = fmax(shuffle_end, host_shuffle_end + message_latency);
+        
+        // Reduce: reducers beyond the core or container count share them, and the job waits for
+        // the largest partition. The model does not track which host it lands on, so every
+        // host is assumed to have one.
+        long largest = get_largest_partition(job);
+        double host_reduce_duration = get_reduce_cost(hdmsg_host->host, job, largest) / MSG_host_get_speed(hdmsg_host->host);
+        double mean_reduce_duration = host_reduce_duration / (get_reducer_share(job, largest) * job->reducers);
+        if (reduce_slots > 0 && host_reducers > reduce_slots)
+        {
+            host_reduce_duration *= (double) host_reducers / reduce_slots;
+            mean_reduce_duration *= (double) host_reducers / reduce_slots;
+        }
+        
+        if (host_reducers > 0)
+        {
+            reduce_duration = fmax(reduce_duration, host_reduce_duration);
+            total_reduce_time += host_reducers * mean_reduce_duration;
+        }
+    }
+    
+    if (map_hosts == 0 || reduce_hosts == 0)
+    {
+        fprintf(stderr, "No worker has a %s slot, the analytic model cannot place the job.\n", (map_hosts == 0) ? "map" : "reduce");
+        result->status = 1;
+        return;
+    }
+    
+    shuffle_end = fmax(shuffle_end, map_end) + message_latency;
+    
+    result->sim_map = (total_chunks > 0) ? total_map_time / total_chunks : 0;
+    result->sim_reduce = total_reduce_time / job->reducers;
+    result->simulation_time = shuffle_end + reduce_duration + message_latency;
+    result->status = 0;
+    
+    compareToActual(result);
+}
+
+/** Runs the analytic model on the job of a result's configuration */
+static void estimate_config(struct SimResult *result)
+{
+    MAP_CALIBRATION_FACTOR = result->map_calibration_factor;
+    REDUCE_CALIBRATION_FACTOR = result->reduce_calibration_factor;
+    struct HdmsgJob *job = newHdmsgJob(0, NULL, result->input_size, result->hdfs_chunk_size, result->reducers);
+    seedRandom(result->seed);
+    distributeHdfsChunks(job);
+    estimateAnalytic(job, result);
+}
+
+/*
+ * Reads analytic_batch_file into configs of the configured job, one per line of
+ * input_mb chunk_mb reducers. Returns the number of configs.
+ */
+static int read_batch(struct SimResult **configs, double map_cf, double reduce_cf)
+{
+    char line[512];
+    long input_mb, chunk_mb, job_reducers;
+    int line_number = 0;
+    int count = 0;
+    
+    FILE * batch_file = fopen(analytic_batch_file, "r");
+    
+    if (batch_file == NULL)
+    {
+        fprintf(stderr, "Error while opening analytic batch %s.\n", analytic_batch_file);
+        exit(1);
+    }
+    
+    xbt_dynar_t parsed = xbt_dynar_new(sizeof(struct SimResult), NULL);
+    struct SimResult config;
+    
+    while (fgets(line, sizeof(line), batch_file) != NULL)
+    {
+        line_number++;
+        line[strcspn(line, "#\n")] = 0;
+        
+        if (strspn(line, " \t") == strlen(line))
+        {
+            continue;
+        }
+        
+        if (sscanf(line, "%ld %ld %ld", &input_mb, &chunk_mb, &job_reducers) != 3 ||
+            input_mb < chunk_mb || chunk_mb <= 0 || job_reducers <= 0)
+        {
+            fprintf(stderr, "Error in analytic batch line %d: %s\n", line_number, line);
+            exit(1);
+        }
+        
+        initSimResult(&config, map_cf, reduce_cf);
+        config.input_size = input_mb;
+        config.hdfs_chunk_size = chunk_mb;
+        config.reducers = job_reducers;
+        xbt_dynar_push(parsed, &config);
+    }
+    
+    fclose(batch_file);
+    
+    count = xbt_dynar_length(parsed);
+    *configs = xbt_dynar_to_array(parsed);
+    
+    return count;
+}
+
+/** Prints one config's estimate, and its simulation when there is one, as a row of the batch table */
+static void print_batch_row(FILE *output_file, struct SimResult *estimated, struct SimResult *simulated)
+{
+    fprintf(output_file, "%ld-%ld-%ld\t%.2f\t\t%.2f\t\t%.2f",
+            estimated->input_size, estimated->hdfs_chunk_size, estimated->reducers,
+            estimated->sim_map, estimated->sim_reduce, estimated->simulation_time);
+    
+    if (analytic_validate && simulated->status == 0)
+    {
+        fprintf(output_file, "\t\t%.2f\t\t%.2f%%", simulated->simulation_time,
+                100 * (estimated->simulation_time - simulated->simulation_time) / simulated->simulation_time);
+    }
+    else if (analytic_validate)
+    {
+        fprintf(output_file, "\t\tfailed\t\t-");
+    }
+    
+    if (estimated->has_actual)
+    {
+        fprintf(output_file, "\t\t%.2f\n", estimated->actual_exec);
+    }
+    else
+    {
+        fprintf(output_file, "\t\t-\n");
+    }
+}
+
+/*
+ * Prints the analytic estimate for one pair of calibration factors and, with
+ * analytic_validate set, how far it is from the full discrete-event simulation.
+ * With analytic_batch_file set, does so for every configuration it lists, one row each,
+ * also written to HDMSG_analytic.txt.
+ */
+int runAnalytic(double map_cf, double reduce_cf)
+{
+    int i;
+    int count = 1;
+    struct timeval start, end;
+    struct SimResult *estimated;
+    
+    if (analytic_batch_file != NULL)
+    {
+        count = read_batch(&estimated, map_cf, reduce_cf);
+        
+        if (count == 0)
+        {
+            fprintf(stderr, "The analytic batch %s has no configurations.\n", analytic_batch_file);
+            free(estimated);
+            return 1;
+        }
+    }
+    else
+    {
+        estimated = xbt_new0(struct SimResult, 1);
+        initSimResult(&estimated[0], map_cf, reduce_cf);
+    }
+    
+    struct SimResult *simulated = xbt_new0(struct SimResult, count);
+    memcpy(simulated, estimated, count * sizeof(struct SimResult));
+    
+    // The simulations run in forked workers before the chunks are distributed in this process
+    if (analytic_validate)
+    {
+        runParallel(simulated, count, get_worker_count(sweep_workers), runSimulation);
+    }
+    
+    gettimeofday(&start, NULL);
+    
+    for (i = 0; i < count; i++)
+    {
+        estimate_config(&estimated[i]);
+        
+        if (estimated[i].status != 0)
+        {
+            free(estimated);
+            free(simulated);
+            return 1;
+        }
+    }
+    
+    gettimeofday(&end, NULL);
+    
+    if (analytic_batch_file != NULL)
+    {
+        FILE * output_file = fopen("HDMSG_analytic.txt", "w");
+        
+        printf("\nConfig\t\tMap\t\tReduce\t\tAnalytic%s\tActual\n", analytic_validate ? "\tSimulated\tDifference" : "");
+        
+        for (i = 0; i < count; i++)
+        {
+            print_batch_row(stdout, &estimated[i], &simulated[i]);
+            print_batch_row(output_file, &estimated[i], &simulated[i]);
+        }
+        
+        fclose(output_file);
+    }
+    else
+    {
+        printf("\n\t\tMap Phase\t\tReduce Phase\t\tExecution Time\n");
+        
+        if (estimated->has_actual)
+        {
+            printf("Actual: %17.2f %26.2f %25.2f\n", estimated->actual_map, estimated->actual_reduce, estimated->actual_exec);
+        }
+        
+        printf("Analytic: %15.2f %26.2f %25.2f\n", estimated->sim_map, estimated->sim_reduce, estimated->simulation_time);
+        
+        if (analytic_validate && simulated->status == 0)
+        {
+            printf("Simulated: %14.2f %26.2f %25.2f\n", simulated->sim_map, simulated->sim_reduce, simulated->simulation_time);
+            printf("Difference: %12.2f%% %25.2f%% %24.2f%%\n",
+                   100 * (estimated->sim_map - simulated->sim_map) / simulated->sim_map,
+                   100 * (estimated->sim_reduce - simulated->sim_reduce) / simulated->sim_reduce,
+                   100 * (estimated->simulation_time - simulated->simulation_time) / simulated->simulation_time);
+        }
+        else if (analytic_validate)
+        {
+            printf("The discrete-event simulation failed, nothing to compare against.\n");
+        }
+    }
+    
+    printf("\nAnalytic estimate%s computed in %ld microseconds\n\n", (count > 1) ? "s" : "",
+           (long) ((end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec)));
+    
+    free(estimated);
+    free(simulated);
+    
+    return 0;
+}
@@ -0,0 +1,49 @@
+//
+//  HdmsgAnalytic.h
+//  HDMSG
+//
+
+#ifndef HDMSGANALYTIC_H
+#define HDMSGANALYTIC_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+#include "HdmsgSweep.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern double analytic_bandwidth;
+extern double analytic_latency;
+extern int analytic_validate;
+extern char *analytic_batch_file;
+
+// Defined in HDMSG.c
+extern double MAP_CALIBRATION_FACTOR;
+extern double REDUCE_CALIBRATION_FACTOR;
+extern long reducers;
+extern long input_size;
+extern long hdfs_chunk_size;
+extern int SHUFFLE_RECEIVERS_PER_REDUCER;
+extern double combiner_ratio;
+extern double compression_ratio;
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+
+// Defined in HDMSG.c
+double get_initialization_cost(msg_host_t);
+double get_map_cost(msg_host_t, struct HdmsgJob *);
+double get_reduce_cost(msg_host_t, struct HdmsgJob *, long);
+double get_compress_cost(msg_host_t, struct HdmsgJob *);
+double get_decompress_cost(msg_host_t, double);
+long get_reducers_to_launch(struct HdmsgJob *, struct HdmsgHost *);
+void distributeHdfsChunks(struct HdmsgJob *);
+
+void estimateAnalytic(struct HdmsgJob *, struct SimResult *);
+int runAnalytic(double, double);
+
+#endif /* HdmsgAnalytic_h */
@@ -0,0 +1,260 @@
+//
+//  HdmsgCalibrate.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <math.h>
+#include "HdmsgCalibrate.h"
+#include "HdmsgGroundTruth.h"
+
+double calibration_start = 1.0;         // Initial guess for both calibration factors
+double calibration_step = 0.1;          // Size of the initial simplex
+double calibration_tolerance = 0.005;   // Stop once every vertex is this close to the best one
+int calibration_max_evaluations = 60;   // Cap on objective evaluations (each one simulates every configuration)
+
+static struct SimResult *calibration_configs;
+static struct SimResult *best_results;
+static double best_objective;
+static int config_count;
+static int evaluations;
+static int workers;
+
+/*
+ * Simulates every calibration configuration with the given factors and returns the
+ * mean of sim_err + avg_percent_diff. Configurations run in parallel.
+ */
+static double evaluate(double map_cf, double reduce_cf)
+{
+    int i;
+    double sum = 0;
+    struct SimResult *results = xbt_new0(struct SimResult, config_count);
+    
+    for (i = 0; i < config_count; i++)
+    {
+        results[i] = calibration_configs[i];
+        results[i].map_calibration_factor = map_cf;
+        results[i].reduce_calibration_factor = reduce_cf;
+    }
+    
+    runParallel(results, config_count, workers, runSimulation);
+    
+    for (i = 0; i < config_count; i++)
+    {
+        // A run that failed can never be the optimum
+        if (results[i].status != 0 || !results[i].has_actual)
+        {
+            sum += 1e6;
+        }
+        else
+        {
+            sum += results[i].sim_err + results[i].avg_percent_diff;
+        }
+    }
+    
+    sum /= config_count;
+    evaluations++;
+    
+    printf("%4d  map_cf %.4f  reduce_cf %.4f  objective %.3f\n", evaluations, map_cf, reduce_cf, sum);
+    
+    if (best_results == NULL || sum < best_objective)
+    {
+        free(best_results);
+        best_results = results;
+        best_objective = sum;
+    }
+    else
+    {
+        free(results);
+    }
+    
+    return sum;
+}
+
+/*
+ * Calibration factors scale costs, so keep them positive
+ */
+static void clamp(double *x)
+{
+    x[0] = (x[0] < 0.01) ? 0.01 : x[0];
+    x[1] = (x[1] < 0.01) ? 0.01 : x[1];
+}
+
+/*
+ * Nelder-Mead over (map_cf, reduce_cf). Returns the best vertex in x[0].
+ */
+static void nelderMead(double x[3][2], double f[3])
+{
+    int i, j;
+    double centroid[2], xr[2], xe[2], xc[2];
+    double fr, fe, fc;
+    
+    for (i = 0; i < 3; i++)
+    {
+        f[i] = evaluate(x[i][0], x[i][1]);
+    }
+    
+    while (evaluations < calibration_max_evaluations)
+    {
+        // Order the vertices from best to worst
+        for (i = 0; i < 3; i++)
+        {
+            for (j = i + 1; j < 3; j++)
+            {
+                if (f[j] < f[i])
+                {
+                    double tf = f[i]; f[i] = f[j]; f[j] = tf;
+                    double t0 = x[i][0]; x[i][0] = x[j][0]; x[j][0] = t0;
+                    double t1 = x[i][1]; x[i][1] = x[j][1]; x[j][1] = t1;
+                }
+            }
+        }
+        
+        // Converged once the simplex has collapsed onto the best vertex
+        double size = 0;
+        for (i = 1; i < 3; i++)
+        {
+            size = fmax(size, fmax(fabs(x[i][0] - x[0][0]), fabs(x[i][1] - x[0][1])));
+        }
+        
+        if (size < calibration_tolerance)
+        {
+            break;
+        }
+        
+        for (j = 0; j < 2; j++)
+        {
+            centroid[j] = (x[0][j] + x[1][j]) / 2;
+            xr[j] = centroid[j] + (centroid[j] - x[2][j]);
+        }
+        clamp(xr);
+        fr = evaluate(xr[0], xr[1]);
+        
+        if (fr < f[0])
+        {
+            // Reflection is the best so far, try going further
+            for (j = 0; j < 2; j++)
+            {
+                xe[j] = centroid[j] + 2 * (centroid[j] - x[2][j]);
+            }
+            clamp(xe);
+            fe = evaluate(xe[0], xe[1]);
+            
+            if (fe < fr)
+            {
+                x[2][0] = xe[0]; x[2][1] = xe[1]; f[2] = fe;
+            }
+            else
+            {
+                x[2][0] = xr[0]; x[2][1] = xr[1]; f[2] = fr;
+            }
+        }
+        else if (fr < f[1])
+        {
+            x[2][0] = xr[0]; x[2][1] = xr[1]; f[2] = fr;
+        }
+        else
+        {
+            // Contract towards the better of the reflected and the worst vertex
+            double *toward = (fr < f[2]) ? xr : x[2];
+            for (j = 0; j < 2; j++)
+            {
+                xc[j] = centroid[j] + 0.5 * (toward[j] - centroid[j]);
+            }
+            fc = evaluate(xc[0], xc[1]);
+            
+            if (fc < fmin(fr, f[2]))
+            {
+                x[2][0] = xc[0]; x[2][1] = xc[1]; f[2] = fc;
+            }
+            else
+            {
+                // Shrink everything towards the best vertex, as far as the evaluation budget goes
+                for (i = 1; i < 3 && evaluations < calibration_max_evaluations; i++)
+                {
+                    x[i][0] = x[0][0] + 0.5 * (x[i][0] - x[0][0]);
+                    x[i][1] = x[0][1] + 0.5 * (x[i][1] - x[0][1]);
+                    f[i] = evaluate(x[i][0], x[i][1]);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Finds the calibration factors that minimize sim_err + avg_percent_diff, either for the
+ * configured job or for every configuration that has cluster measurements.
+ */
+int runCalibration(int all_configurations)
+{
+    int i;
+    double actual_map, actual_reduce, actual_exec;
+    
+    workers = get_worker_count(sweep_workers);
+    calibration_configs = xbt_new0(struct SimResult, getMeasuredConfigCount() + 1);
+    
+    if (all_configurations)
+    {
+        config_count = getMeasuredConfigs(calibration_configs, calibration_start, calibration_start);
+        
+        if (config_count == 0)
+        {
+            fprintf(stderr, "There are no cluster measurements for platform %s to calibrate against.\n", ground_truth_platform);
+            return 1;
+        }
+    }
+    else
+    {
+        initSimResult(&calibration_configs[0], calibration_start, calibration_start);
+        config_count = 1;
+        
+        if (!getActualTimes(calibration_configs[0].input_size, calibration_configs[0].hdfs_chunk_size,
+                            calibration_configs[0].reducers, &actual_map, &actual_reduce, &actual_exec))
+        {
+            fprintf(stderr, "There are no cluster measurements to calibrate this configuration against.\n");
+            return 1;
+        }
+    }
+    
+    printf("\nCalibrating against %d configuration(s) on %d workers\n", config_count, workers);
+    
+    double x[3][2] = {
+        { calibration_start, calibration_start },
+        { calibration_start + calibration_step, calibration_start },
+        { calibration_start, calibration_start + calibration_step }
+    };
+    double f[3];
+    
+    nelderMead(x, f);
+    
+    printf("\nCalibration Factors: %.4f, %.4f after %d evaluations (%d simulations)\n",
+           best_results[0].map_calibration_factor,
+           best_results[0].reduce_calibration_factor,
+           evaluations,
+           evaluations * config_count);
+    
+    printf("\nConfig\t\tMap\t\tReduce\t\tSim_Time\tSim_Err\t\tPercent_Diff\n");
+    
+    FILE * output_file = fopen("HDMSG_output.txt", "a");
+    
+    for (i = 0; i < config_count; i++)
+    {
+        struct SimResult *r = &best_results[i];
+        
+        printf("%ld-%ld-%ld\t%.2f\t\t%.2f\t\t%.2f\t\t%.2f%%\t\t%.2f%%\n",
+               r->input_size, r->hdfs_chunk_size, r->reducers,
+               r->sim_map, r->sim_reduce, r->simulation_time, r->sim_err, r->avg_percent_diff);
+        
+        if (output_file != NULL)
+        {
+            writeSimResult(output_file, r);
+        }
+    }
+    
+    if (output_file != NULL)
+    {
+        fclose(output_file);
+    }
+    
+    return 0;
+}
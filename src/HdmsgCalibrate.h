@@ -0,0 +1,26 @@
+//
+//  HdmsgCalibrate.h
+//  HDMSG
+//
+
+#ifndef HDMSGCALIBRATE_H
+#define HDMSGCALIBRATE_H
+
+#include <stdio.h>
+#include "HdmsgSweep.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern double calibration_start;
+extern double calibration_step;
+extern double calibration_tolerance;
+extern int calibration_max_evaluations;
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+int runCalibration(int);
+
+#endif /* HdmsgCalibrate_h */
@@ -0,0 +1,636 @@
+//
+//  HdmsgConfig.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include "HdmsgConfig.h"
+#include "HdmsgSweep.h"
+#include "HdmsgCalibrate.h"
+#include "HdmsgAnalytic.h"
+#include "HdmsgSkew.h"
+#include "HdmsgHdfs.h"
+#include "HdmsgRandom.h"
+#include "HdmsgSpeculate.h"
+#include "HdmsgFailure.h"
+#include "HdmsgWorkload.h"
+#include "HdmsgYarn.h"
+#include "HdmsgDisk.h"
+#include "HdmsgTrace.h"
+#include "HdmsgMetrics.h"
+#include "HdmsgReplicate.h"
+#include "HdmsgGroundTruth.h"
+
+#define NO_MAX HUGE_VAL
+
+static char *config_path;
+
+// Parsed into pull_shuffle once the file is read
+static char *shuffle_mode = "push";
+
+// Every key a config file can set. A key may be set once, except master and worker, which
+// add hosts on every line they appear.
+static struct ConfigKey config_keys[] =
+{
+    // key                              type            value                           min, above_min, max     choices
+    { "master",                         CONFIG_HOSTS,   NULL,                           0, 0, 0,                NULL },
+    { "worker",                         CONFIG_HOSTS,   NULL,                           0, 0, 0,                NULL },
+    { "platform",                       CONFIG_IGNORED, NULL,                           0, 0, 0,                NULL },
+    { "mappers",                        CONFIG_LONG,    &mappers,                       0, 0, NO_MAX,           NULL },
+    { "reducers",                       CONFIG_LONG,    &reducers,                      1, 0, NO_MAX,           NULL },
+    { "input_size_in_mb",               CONFIG_LONG,    &input_size,                    1, 0, NO_MAX,           NULL },
+    { "hdfs_chunk_size_in_mb",          CONFIG_LONG,    &hdfs_chunk_size,               1, 0, NO_MAX,           NULL },
+    { "shuffle_receivers_per_reducer",  CONFIG_INT,     &SHUFFLE_RECEIVERS_PER_REDUCER, 1, 0, NO_MAX,           NULL },
+    { "shuffle_mode",                   CONFIG_CHOICE,  &shuffle_mode,                  0, 0, 0,                "push|pull" },
+    { "shuffle_parallelcopies",         CONFIG_INT,     &SHUFFLE_PARALLELCOPIES,        1, 0, NO_MAX,           NULL },
+    { "shuffle_memory_limit_percent",   CONFIG_DOUBLE,  &shuffle_memory_limit_percent,  0, 0, 1,                NULL },
+    { "shuffle_merge_percent",          CONFIG_DOUBLE,  &shuffle_merge_percent,         0, 0, 1,                NULL },
+    { "reduce_slowstart",               CONFIG_DOUBLE,  &reduce_slowstart,              0, 0, 1,                NULL },
+    { "reduce_merge_fraction",          CONFIG_DOUBLE,  &reduce_merge_fraction,         0, 0, 1,                NULL },
+    { "combiner_ratio",                 CONFIG_DOUBLE,  &combiner_ratio,                0, 1, NO_MAX,           NULL },
+    { "compression_ratio",              CONFIG_DOUBLE,  &compression_ratio,             0, 1, NO_MAX,           NULL },
+    { "compress_cost_per_mb",           CONFIG_DOUBLE,  &compress_cost_per_mb,          0, 0, NO_MAX,           NULL },
+    { "decompress_cost_per_mb",         CONFIG_DOUBLE,  &decompress_cost_per_mb,        0, 0, NO_MAX,           NULL },
+    { "hdfs_replication",               CONFIG_INT,     &hdfs_replication,              1, 0, NO_MAX,           NULL },
+    { "hdfs_placement",                 CONFIG_CHOICE,  &hdfs_placement,                0, 0, 0,                "rack_aware|random|pinned" },
+    { "hdfs_pinned_hosts",              CONFIG_STRING,  &hdfs_pinned_hosts,             0, 0, 0,                NULL },
+    { "work_stealing",                  CONFIG_INT,     &work_stealing,                 0, 0, 1,                NULL },
+    { "heterogeneous_speeds",           CONFIG_INT,     &heterogeneous_speeds,          0, 0, 1,                NULL },
+    { "locality_delay",                 CONFIG_DOUBLE,  &locality_delay,                0, 0, NO_MAX,           NULL },
+    { "straggler_task_fraction",        CONFIG_DOUBLE,  &straggler_task_fraction,       0, 0, 1,                NULL },
+    { "straggler_host_fraction",        CONFIG_DOUBLE,  &straggler_host_fraction,       0, 0, 1,                NULL },
+    { "straggler_factor",               CONFIG_DOUBLE,  &straggler_factor,              0, 1, NO_MAX,           NULL },
+    { "speculative_execution",          CONFIG_INT,     &speculative_execution,         0, 0, 1,                NULL },
+    { "speculation_policy",             CONFIG_CHOICE,  &speculation_policy,            0, 0, 0,                "late|default" },
+    { "speculation_interval",           CONFIG_DOUBLE,  &speculation_interval,          0, 1, NO_MAX,           NULL },
+    { "speculative_cap",                CONFIG_DOUBLE,  &speculative_cap,               0, 0, 1,                NULL },
+    { "failure_hosts",                  CONFIG_STRING,  &failure_hosts,                 0, 0, 0,                NULL },
+    { "failure_mtbf",                   CONFIG_DOUBLE,  &failure_mtbf,                  0, 0, NO_MAX,           NULL },
+    { "failure_detection_timeout",      CONFIG_DOUBLE,  &failure_detection_timeout,     0, 0, NO_MAX,           NULL },
+    { "failure_task_probability",       CONFIG_DOUBLE,  &failure_task_probability,      0, 0, 1,                NULL },
+    { "failure_max_attempts",           CONFIG_INT,     &failure_max_attempts,          1, 0, NO_MAX,           NULL },
+    { "failure_blacklist_threshold",    CONFIG_INT,     &failure_blacklist_threshold,   0, 0, NO_MAX,           NULL },
+    { "failure_retry_interval",         CONFIG_DOUBLE,  &failure_retry_interval,        0, 1, NO_MAX,           NULL },
+    { "random_seed",                    CONFIG_SEED,    &random_seed,                   0, 0, NO_MAX,           NULL },
+    { "yarn_node_memory_mb",            CONFIG_LONG,    &yarn_node_memory_mb,           0, 0, NO_MAX,           NULL },
+    { "yarn_node_vcores",               CONFIG_INT,     &yarn_node_vcores,              0, 0, NO_MAX,           NULL },
+    { "map_container_mb",               CONFIG_LONG,    &map_container_mb,              1, 0, NO_MAX,           NULL },
+    { "map_container_vcores",           CONFIG_INT,     &map_container_vcores,          1, 0, NO_MAX,           NULL },
+    { "reduce_container_mb",            CONFIG_LONG,    &reduce_container_mb,           1, 0, NO_MAX,           NULL },
+    { "reduce_container_vcores",        CONFIG_INT,     &reduce_container_vcores,       1, 0, NO_MAX,           NULL },
+    { "disk_bandwidth_mbps",            CONFIG_DOUBLE,  &disk_bandwidth,                0, 0, NO_MAX,           NULL },
+    { "io_sort_mb",                     CONFIG_DOUBLE,  &io_sort_mb,                    0, 1, NO_MAX,           NULL },
+    { "io_sort_spill_percent",          CONFIG_DOUBLE,  &io_sort_spill_percent,         0, 1, 1,                NULL },
+    { "io_sort_factor",                 CONFIG_INT,     &io_sort_factor,                2, 0, NO_MAX,           NULL },
+    { "sort_cost_per_mb",               CONFIG_DOUBLE,  &sort_cost_per_mb,              0, 0, NO_MAX,           NULL },
+    { "reduce_shuffle_buffer_mb",       CONFIG_DOUBLE,  &reduce_shuffle_buffer_mb,      0, 0, NO_MAX,           NULL },
+    { "reduce_output_ratio",            CONFIG_DOUBLE,  &reduce_output_ratio,           0, 0, NO_MAX,           NULL },
+    { "trace_file",                     CONFIG_STRING,  &trace_file,                    0, 0, 0,                NULL },
+    { "metrics_file",                   CONFIG_STRING,  &metrics_file,                  0, 0, 0,                NULL },
+    { "metrics_interval",               CONFIG_DOUBLE,  &metrics_interval,              0, 1, NO_MAX,           NULL },
+    { "workload_file",                  CONFIG_STRING,  &workload_file,                 0, 0, 0,                NULL },
+    { "workload_scheduler",             CONFIG_CHOICE,  &workload_scheduler,            0, 0, 0,                "fifo|fair|capacity" },
+    { "workload_queues",                CONFIG_STRING,  &workload_queues,               0, 0, 0,                NULL },
+    { "workload_sample_interval",       CONFIG_DOUBLE,  &workload_sample_interval,      0, 1, NO_MAX,           NULL },
+    { "key_distribution",               CONFIG_CHOICE,  &key_distribution,              0, 0, 0,                "uniform|zipf|histogram" },
+    { "key_zipf_s",                     CONFIG_DOUBLE,  &key_zipf_s,                    0, 0, NO_MAX,           NULL },
+    { "key_count",                      CONFIG_LONG,    &key_count,                     1, 0, NO_MAX,           NULL },
+    { "key_histogram_file",             CONFIG_STRING,  &key_histogram_file,            0, 0, 0,                NULL },
+    { "sweep_min",                      CONFIG_DOUBLE,  &sweep_min,                     0, 0, NO_MAX,           NULL },
+    { "sweep_max",                      CONFIG_DOUBLE,  &sweep_max,                     0, 0, NO_MAX,           NULL },
+    { "sweep_step",                     CONFIG_DOUBLE,  &sweep_step,                    0, 1, NO_MAX,           NULL },
+    { "sweep_workers",                  CONFIG_INT,     &sweep_workers,                 0, 0, NO_MAX,           NULL },
+    { "replications",                   CONFIG_INT,     &replications,                  2, 0, NO_MAX,           NULL },
+    { "replication_min",                CONFIG_INT,     &replication_min,               2, 0, NO_MAX,           NULL },
+    { "replication_ci_width",           CONFIG_DOUBLE,  &replication_ci_width,          0, 1, NO_MAX,           NULL },
+    { "ground_truth_file",              CONFIG_STRING,  &ground_truth_file,             0, 0, 0,                NULL },
+    { "ground_truth_platform",          CONFIG_STRING,  &ground_truth_platform,         0, 0, 0,                NULL },
+    { "calibration_start",              CONFIG_DOUBLE,  &calibration_start,             0, 1, NO_MAX,           NULL },
+    { "calibration_step",               CONFIG_DOUBLE,  &calibration_step,              0, 1, NO_MAX,           NULL },
+    { "calibration_tolerance",          CONFIG_DOUBLE,  &calibration_tolerance,         0, 1, NO_MAX,           NULL },
+    { "calibration_max_evaluations",    CONFIG_INT,     &calibration_max_evaluations,   1, 0, NO_MAX,           NULL },
+    { "analytic_bandwidth_in_mbps",     CONFIG_DOUBLE,  &analytic_bandwidth,            0, 1, NO_MAX,           NULL },
+    { "analytic_latency_in_ms",         CONFIG_DOUBLE,  &analytic_latency,              0, 0, NO_MAX,           NULL },
+    { "analytic_validate",              CONFIG_INT,     &analytic_validate,             0, 0, 1,                NULL },
+    { "analytic_batch_file",            CONFIG_STRING,  &analytic_batch_file,           0, 0, 0,                NULL },
+    { NULL }
+};
+
+// Ranges are matched against every platform host. Single hosts are looked up by name, so
+// a config listing thousands of hosts one by one is as fast as one with a range.
+static xbt_dynar_t host_ranges;     // struct HostRange * with a number interval
+static xbt_dict_t single_hosts;     // First struct HostRange * of each single host name
+
+/*
+ * Reports an error at a line of the config file and exits
+ */
+static void config_error(int line, const char *format, ...)
+{
+    va_list args;
+    
+    fprintf(stderr, "Error in config file %s, line %d: ", config_path, line);
+    
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static struct ConfigKey *get_config_key(const char *key)
+{
+    struct ConfigKey *entry;
+    
+    for (entry = config_keys; entry->key != NULL; entry++)
+    {
+        if (strcmp(entry->key, key) == 0)
+        {
+            return entry;
+        }
+    }
+    
+    return NULL;
+}
+
+/*
+ * Returns the next token of a line and moves the cursor past it, or NULL at the end of
+ * the line. Unlike strsep, delimiters in a row make no empty tokens.
+ */
+static char *next_token(char **cursor, const char *delimiters)
+{
+    char *token = *cursor + strspn(*cursor, delimiters);
+    
+    if (*token == '\0')
+    {
+        return NULL;
+    }
+    
+    *cursor = token + strcspn(token, delimiters);
+    
+    if (**cursor != '\0')
+    {
+        **cursor = '\0';
+        (*cursor)++;
+    }
+    
+    return token;
+}
+
+static int is_choice(const char *choices, const char *value)
+{
+    size_t length = strlen(value);
+    const char *choice = choices;
+    
+    while (choice != NULL)
+    {
+        if (strncmp(choice, value, length) == 0 && (choice[length] == '|' || choice[length] == '\0'))
+        {
+            return 1;
+        }
+        
+        choice = strchr(choice, '|');
+        choice = (choice != NULL) ? choice + 1 : NULL;
+    }
+    
+    return 0;
+}
+
+/*
+ * Parses a number for an int, long, unsigned long or double key and checks its bounds
+ */
+static void set_number(struct ConfigKey *entry, const char *value, int line)
+{
+    char *end;
+    long integer = 0;
+    unsigned long seed = 0;
+    double number;
+    
+    errno = 0;
+    
+    if (entry->type == CONFIG_DOUBLE)
+    {
+        number = strtod(value, &end);
+    }
+    else if (entry->type == CONFIG_SEED)
+    {
+        seed = strtoul(value, &end, 10);
+        number = (*value == '-') ? -1 : (double) seed;
+    }
+    else
+    {
+        integer = strtol(value, &end, 10);
+        number = (double) integer;
+    }
+    
+    if (end == value || *end != '\0' || isnan(number))
+    {
+        config_error(line, "%s expects %s, not %s", entry->key,
+                     (entry->type == CONFIG_DOUBLE) ? "a number" : "an integer", value);
+    }
+    
+    if (errno == ERANGE || (entry->type == CONFIG_INT && (integer > INT_MAX || integer < INT_MIN)))
+    {
+        config_error(line, "%s is out of range: %s", entry->key, value);
+    }
+    
+    if (number < entry->min || (entry->above_min && number == entry->min) || number > entry->max)
+    {
+        if (entry->max == NO_MAX)
+        {
+            config_error(line, "%s must be %s %g, not %s", entry->key,
+                         entry->above_min ? "greater than" : "at least", entry->min, value);
+        }
+        
+        config_error(line, "%s must be %s %g and at most %g, not %s", entry->key,
+                     entry->above_min ? "greater than" : "at least", entry->min, entry->max, value);
+    }
+    
+    switch (entry->type)
+    {
+        case CONFIG_INT:
+            *(int *) entry->value = (int) integer;
+            break;
+        case CONFIG_LONG:
+            *(long *) entry->value = integer;
+            break;
+        case CONFIG_SEED:
+            *(unsigned long *) entry->value = seed;
+            break;
+        default:
+            *(double *) entry->value = number;
+            break;
+    }
+}
+
+/*
+ * Finds the last number in a host name. Returns 0 if the name has no digit.
+ */
+static int split_host_name(const char *name, size_t *prefix_length, size_t *digits_length)
+{
+    size_t end = strlen(name);
+    size_t start;
+    
+    while (end > 0 && !isdigit(name[end - 1]))
+    {
+        end--;
+    }
+    
+    for (start = end; start > 0 && isdigit(name[start - 1]); start--);
+    
+    *prefix_length = start;
+    *digits_length = end - start;
+    
+    return (end > 0);
+}
+
+/*
+ * Adds a host name, or a range like host1-host4 or node001-node128.lan, to a role
+ */
+static void add_host_range(int role, char *token, int line)
+{
+    struct HostRange *range = xbt_new0(struct HostRange, 1);
+    char *dash;
+    
+    range->role = role;
+    range->line = line;
+    range->first = -1;
+    range->last = -1;
+    
+    // Both ends of a range have the same prefix and suffix around their numbers. Host
+    // names may contain dashes as well, so each dash is tried as the separator.
+    for (dash = strchr(token, '-'); dash != NULL && range->prefix == NULL; dash = strchr(dash + 1, '-'))
+    {
+        char *last_name = dash + 1;
+        size_t first_prefix, first_digits, last_prefix, last_digits;
+        
+        *dash = '\0';
+        
+        if (split_host_name(token, &first_prefix, &first_digits) &&
+            split_host_name(last_name, &last_prefix, &last_digits) &&
+            first_prefix == last_prefix &&
+            strncmp(token, last_name, first_prefix) == 0 &&
+            strcmp(token + first_prefix + first_digits, last_name + last_prefix + last_digits) == 0)
+        {
+            range->prefix = bprintf("%.*s", (int) first_prefix, token);
+            range->suffix = xbt_strdup(token + first_prefix + first_digits);
+            range->first = strtol(token + first_prefix, NULL, 10);
+            range->last = strtol(last_name + last_prefix, NULL, 10);
+            range->width = (first_digits > 1 && token[first_prefix] == '0') ? (int) first_digits : 0;
+            
+            if (range->first > range->last)
+            {
+                config_error(line, "host range %s-%s is empty", token, last_name);
+            }
+        }
+        
+        *dash = '-';
+    }
+    
+    if (range->prefix == NULL)
+    {
+        range->prefix = xbt_strdup(token);
+        range->suffix = xbt_strdup("");
+        range->next = xbt_dict_get_or_null(single_hosts, token);
+        xbt_dict_set(single_hosts, token, range, NULL);
+    }
+    else
+    {
+        xbt_dynar_push(host_ranges, &range);
+    }
+    
+    range->prefix_length = strlen(range->prefix);
+    range->suffix_length = strlen(range->suffix);
+}
+
+static long get_range_size(struct HostRange *range)
+{
+    return range->last - range->first + 1;
+}
+
+static int range_contains(struct HostRange *range, const char *name)
+{
+    size_t name_length = strlen(name);
+    
+    if (name_length <= range->prefix_length + range->suffix_length ||
+        strncmp(name, range->prefix, range->prefix_length) != 0 ||
+        strcmp(name + name_length - range->suffix_length, range->suffix) != 0)
+    {
+        return 0;
+    }
+    
+    // The suffix has no digits, so the number is everything between prefix and suffix
+    const char *digits = name + range->prefix_length;
+    size_t digits_length = name_length - range->prefix_length - range->suffix_length;
+    
+    if (strspn(digits, "0123456789") != digits_length)
+    {
+        return 0;
+    }
+    
+    if ((range->width > 0) ? (digits_length != (size_t) range->width) : (digits_length > 1 && digits[0] == '0'))
+    {
+        return 0;
+    }
+    
+    long number = strtol(digits, NULL, 10);
+    return (number >= range->first && number <= range->last);
+}
+
+static void set_value(struct ConfigKey *entry, char *value, int line)
+{
+    switch (entry->type)
+    {
+        case CONFIG_IGNORED:
+            break;
+        case CONFIG_STRING:
+            *(char **) entry->value = xbt_strdup(value);
+            break;
+        case CONFIG_CHOICE:
+            if (!is_choice(entry->choices, value))
+            {
+                config_error(line, "%s must be one of %s, not %s", entry->key, entry->choices, value);
+            }
+        
+            *(char **) entry->value = xbt_strdup(value);
+            break;
+        default:
+            set_number(entry, value, line);
+            break;
+    }
+}
+
+/** Read the MapReduce job configuration file and set parameters, for the mode or NULL for one job */
+void readConfig(char *path, const char *mode)
+{
+    char *line = NULL;
+    size_t capacity = 0;
+    int line_number = 0;
+    long number_of_masters = 0;
+    unsigned int cursor;
+    struct HostRange *range;
+    
+    config_path = path;
+    
+    // Read config file and set parameters
+    FILE * config_file = fopen(config_path, "r");
+    
+    if (config_file == NULL)
+    {
+        fprintf(stderr, "Error while opening config file.\n");
+        exit(1);
+    }
+    
+    host_ranges = xbt_dynar_new(sizeof(struct HostRange *), NULL);
+    single_hosts = xbt_dict_new();
+    
+    // One pass over the file, any line length. Everything after a # is a comment.
+    while (getline(&line, &capacity, config_file) != -1)
+    {
+        line_number++;
+        line[strcspn(line, "#\r\n")] = '\0';
+        
+        char *line_cursor = line;
+        char *key = next_token(&line_cursor, " \t");
+        char *value;
+        
+        if (key == NULL)
+        {
+            continue;
+        }
+        
+        struct ConfigKey *entry = get_config_key(key);
+        
+        if (entry == NULL)
+        {
+            config_error(line_number, "unknown key %s", key);
+        }
+        
+        // master and worker take any number of names and ranges, separated by spaces or commas
+        if (entry->type == CONFIG_HOSTS)
+        {
+            int role = (strcmp(key, "master") == 0) ? HOST_MASTER : HOST_WORKER;
+            int names = 0;
+            
+            while ((value = next_token(&line_cursor, " \t,")) != NULL)
+            {
+                add_host_range(role, value, line_number);
+                names++;
+            }
+            
+            if (names == 0)
+            {
+                config_error(line_number, "%s expects host names", key);
+            }
+            
+            entry->line = line_number;
+            continue;
+        }
+        
+        if (entry->line > 0)
+        {
+            config_error(line_number, "%s is already set on line %d", key, entry->line);
+        }
+        
+        value = next_token(&line_cursor, " \t");
+        
+        if (entry->type != CONFIG_IGNORED && (value == NULL || next_token(&line_cursor, " \t") != NULL))
+        {
+            config_error(line_number, "%s expects one value", key);
+        }
+        
+        entry->line = line_number;
+        set_value(entry, value, line_number);
+    }
+    
+    free(line);
+    fclose(config_file);
+    
+    input_size_bytes = input_size * BYTES_PER_MEGABYTE;
+    hdfs_chunk_size_bytes = hdfs_chunk_size * BYTES_PER_MEGABYTE;
+    pull_shuffle = (strcmp(shuffle_mode, "pull") == 0);
+    
+    // Setting a slowstart, even 1.0, launches reducers with the maps and merges as segments arrive
+    pipelined_reduce = (get_config_key("reduce_slowstart")->line > 0);
+    
+    // Keys that only make sense together
+    if (strcmp(key_distribution, "histogram") == 0 && key_histogram_file == NULL)
+    {
+        config_error(get_config_key("key_distribution")->line, "key_distribution histogram needs key_histogram_file");
+    }
+    
+    if (strcmp(hdfs_placement, "pinned") == 0 && hdfs_pinned_hosts == NULL)
+    {
+        config_error(get_config_key("hdfs_placement")->line, "hdfs_placement pinned needs hdfs_pinned_hosts");
+    }
+    
+    // Lost map output is only recovered when reducers fetch it from wherever the map ran last
+    if (failure_hosts != NULL || failure_mtbf > 0)
+    {
+        int line = get_config_key(failure_hosts != NULL ? "failure_hosts" : "failure_mtbf")->line;
+        
+        if (!pull_shuffle)
+        {
+            config_error(line, "host crashes need shuffle_mode pull");
+        }
+        
+        if (speculative_execution)
+        {
+            config_error(line, "host crashes cannot be combined with speculative_execution");
+        }
+    }
+    
+    if (sweep_min > sweep_max)
+    {
+        config_error(get_config_key(get_config_key("sweep_min")->line ? "sweep_min" : "sweep_max")->line,
+                     "sweep_min %g is above sweep_max %g", sweep_min, sweep_max);
+    }
+    
+    if (replication_min > replications)
+    {
+        config_error(get_config_key(get_config_key("replication_min")->line ? "replication_min" : "replications")->line,
+                     "replication_min %d is above replications %d", replication_min, replications);
+    }
+    
+    if (mode != NULL && strcmp(mode, "--workload") == 0 && workload_file == NULL)
+    {
+        fprintf(stderr, "The workload mode needs a trace, set workload_file in config file %s.\n", config_path);
+        exit(1);
+    }
+    
+    // Must have exactly one master process
+    xbt_dynar_foreach (host_ranges, cursor, range)
+    {
+        number_of_masters += (range->role == HOST_MASTER) ? get_range_size(range) : 0;
+    }
+    
+    xbt_dict_cursor_t dict_cursor = NULL;
+    char *name;
+    
+    xbt_dict_foreach (single_hosts, dict_cursor, name, range)
+    {
+        for (; range != NULL; range = range->next)
+        {
+            number_of_masters += (range->role == HOST_MASTER) ? 1 : 0;
+        }
+    }
+    
+    if (number_of_masters != 1)
+    {
+        fprintf(stderr, "There must be exactly one master process.\n");
+        exit(1);
+    }
+    
+    if (get_config_key("worker")->line == 0)
+    {
+        fprintf(stderr, "There must be at least one worker.\n");
+        exit(1);
+    }
+}
+
+/*
+ * Returns the roles the config gives a platform host, HOST_MASTER and HOST_WORKER or'ed
+ * together, 0 if it is not in the config
+ */
+int match_host_roles(const char *name)
+{
+    int roles = 0;
+    unsigned int cursor;
+    struct HostRange *range;
+    
+    for (range = xbt_dict_get_or_null(single_hosts, name); range != NULL; range = range->next)
+    {
+        roles |= range->role;
+        range->matched++;
+    }
+    
+    xbt_dynar_foreach (host_ranges, cursor, range)
+    {
+        if (range_contains(range, name))
+        {
+            roles |= range->role;
+            range->matched++;
+        }
+    }
+    
+    return roles;
+}
+
+/*
+ * Once every platform host went through match_host_roles, exits if the config names a
+ * host the platform does not have
+ */
+void checkHostRanges()
+{
+    unsigned int cursor;
+    struct HostRange *range;
+    
+    xbt_dynar_foreach (host_ranges, cursor, range)
+    {
+        if (range->matched != get_range_size(range))
+        {
+            config_error(range->line, "host range %s%0*ld%s-%s%0*ld%s names %ld hosts that are not in the platform",
+                         range->prefix, range->width, range->first, range->suffix,
+                         range->prefix, range->width, range->last, range->suffix,
+                         get_range_size(range) - range->matched);
+        }
+    }
+    
+    xbt_dict_cursor_t dict_cursor = NULL;
+    char *name;
+    
+    xbt_dict_foreach (single_hosts, dict_cursor, name, range)
+    {
+        if (range->matched == 0)
+        {
+            config_error(range->line, "host %s is not in the platform", name);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+//
+//  HdmsgConfig.h
+//  HDMSG
+//
+
+#ifndef HDMSGCONFIG_H
+#define HDMSGCONFIG_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+
+// How the value of a key is parsed
+#define CONFIG_INT 0
+#define CONFIG_LONG 1
+#define CONFIG_SEED 2           // unsigned long
+#define CONFIG_DOUBLE 3
+#define CONFIG_STRING 4
+#define CONFIG_CHOICE 5         // A string out of the key's choices
+#define CONFIG_HOSTS 6          // Host names and ranges, any number per line
+#define CONFIG_IGNORED 7        // Accepted for older config files, not used
+
+// Defined in HDMSG.c
+extern int BYTES_PER_MEGABYTE;
+extern int SHUFFLE_RECEIVERS_PER_REDUCER;
+extern int SHUFFLE_PARALLELCOPIES;
+extern int pull_shuffle;
+extern int pipelined_reduce;
+extern double reduce_slowstart;
+extern double reduce_merge_fraction;
+extern double combiner_ratio;
+extern double compression_ratio;
+extern double compress_cost_per_mb;
+extern double decompress_cost_per_mb;
+extern int number_of_workers;
+extern long mappers;
+extern long reducers;
+extern long input_size;
+extern long input_size_bytes;
+extern long hdfs_chunk_size;
+extern long hdfs_chunk_size_bytes;
+extern int heterogeneous_speeds;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// A config key, the global it sets and the values it accepts
+struct ConfigKey
+{
+    const char *key;
+    int type;
+    void *value;
+    double min;
+    int above_min;              // 1 if the value must be greater than min, not equal to it
+    double max;
+    const char *choices;        // "|" separated, for CONFIG_CHOICE
+    int line;                   // Line that set the key, 0 if it was not set
+};
+
+// Hosts named in the config, as prefix, number and suffix so a range of thousands of
+// hosts is one entry. A name that is not a range is a single host with first = last = -1.
+struct HostRange
+{
+    int role;                   // HOST_MASTER or HOST_WORKER
+    int line;
+    
+    char *prefix;               // "host" in host1-host4, or the whole name of a single host
+    char *suffix;               // After the number, never contains a digit
+    size_t prefix_length;
+    size_t suffix_length;
+    long first;
+    long last;
+    int width;                  // Digits of zero padded numbers, 0 if they are not padded
+    
+    long matched;               // Platform hosts found in the range
+    struct HostRange *next;     // Next single host entry with the same name
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void readConfig(char *, const char *);
+int match_host_roles(const char *);
+void checkHostRanges();
+
+#endif /* HdmsgConfig_h */
@@ -0,0 +1,263 @@
+//
+//  HdmsgDisk.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <errno.h>
+#include "HdmsgDisk.h"
+#include "HdmsgPool.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Local disk of every worker in MB/s, serving one request at a time. A host property
+// disk_bandwidth_mbps in the platform file overrides it for one node. With 0 there is no
+// disk model, and map and reduce tasks are one computation each.
+double disk_bandwidth = 0;
+
+// Map side: the sort buffer (io.sort.mb) spills once it is io.sort.spill.percent full, and
+// the spills are merged io.sort.factor at a time into the map's output file.
+double io_sort_mb = 100;
+double io_sort_spill_percent = 0.8;
+int io_sort_factor = 10;
+double sort_cost_per_mb = 0;            // Seconds of one core to sort one MB of a spill
+
+// Reduce side: shuffled segments stay in memory until this buffer is full, then go to disk.
+// The default is 70% of the 200 MB default heap of a Hadoop 1 child JVM.
+double reduce_shuffle_buffer_mb = 140;
+double shuffle_memory_limit_percent = 0.25;    // Larger segments go straight to disk
+double shuffle_merge_percent = 0.66;           // Buffer fill that merges its segments to disk
+double reduce_output_ratio = 1.0;       // Reduce output over its uncompressed input
+
+double map_spilled_bytes = 0;
+double reduce_spilled_bytes = 0;
+double disk_bytes_read = 0;
+double disk_bytes_written = 0;
+
+int disk_enabled()
+{
+    return (disk_bandwidth > 0);
+}
+
+/*
+ * Sets each worker's disk bandwidth from the config and its disk_bandwidth_mbps platform
+ * property, which must be a positive number like the config key
+ */
+void assignDiskBandwidths()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        const char *bandwidth = MSG_host_get_property_value(hdmsg_host->host, "disk_bandwidth_mbps");
+        double mbps = disk_bandwidth;
+        
+        if (bandwidth != NULL)
+        {
+            char *end;
+            
+            errno = 0;
+            mbps = strtod(bandwidth, &end);
+            
+            if (end == bandwidth || *end != '\0' || errno == ERANGE || !(mbps > 0) || isinf(mbps))
+            {
+                fprintf(stderr, "disk_bandwidth_mbps of host %s must be a number greater than 0, not %s\n", hdmsg_host->host_name, bandwidth);
+                exit(1);
+            }
+        }
+        
+        hdmsg_host->disk_bandwidth = mbps * 1e6;
+    }
+}
+
+/*
+ * Holds the host's disk for as long as moving the bytes takes. Requests queue for the disk
+ * in order.
+ */
+static void disk_io(struct HdmsgHost *this_host, double bytes)
+{
+    if (this_host->disk == NULL)
+    {
+        this_host->disk = MSG_sem_init(1);
+    }
+    
+    MSG_sem_acquire(this_host->disk);
+    MSG_process_sleep(bytes / this_host->disk_bandwidth);
+    MSG_sem_release(this_host->disk);
+    simulation_events += 2;
+    
+    this_host->disk_busy_time += bytes / this_host->disk_bandwidth;
+}
+
+void disk_read(struct HdmsgHost *this_host, double bytes)
+{
+    if (!disk_enabled() || bytes <= 0)
+    {
+        return;
+    }
+    
+    disk_io(this_host, bytes);
+    disk_bytes_read += bytes;
+}
+
+void disk_write(struct HdmsgHost *this_host, double bytes)
+{
+    if (!disk_enabled() || bytes <= 0)
+    {
+        return;
+    }
+    
+    disk_io(this_host, bytes);
+    disk_bytes_written += bytes;
+}
+
+/*
+ * Returns the number of merge passes that reduce a number of sorted segments to one,
+ * merging io_sort_factor at a time
+ */
+long get_merge_passes(long segments)
+{
+    long passes = 0;
+    
+    while (segments > 1)
+    {
+        segments = (segments + io_sort_factor - 1) / io_sort_factor;
+        passes++;
+    }
+    
+    return passes;
+}
+
+/*
+ * Sorts and spills a map task's output of the given uncompressed size, then merges the
+ * spills into its output file. Every merge pass reads and writes the whole output.
+ */
+void spillMapOutput(struct HdmsgHost *this_host, double output_bytes)
+{
+    long i;
+    double output_mb = output_bytes / BYTES_PER_MEGABYTE;
+    double spill_mb = io_sort_mb * io_sort_spill_percent;
+    long spills = (long) ceil(output_mb / spill_mb);
+    
+    if (!disk_enabled() || spills == 0)
+    {
+        return;
+    }
+    
+    for (i = 0; i < spills; i++)
+    {
+        double this_spill_mb = fmin(spill_mb, output_mb - i * spill_mb);
+        
+        if (sort_cost_per_mb > 0)
+        {
+            execute_task("sort", this_spill_mb * sort_cost_per_mb * get_reference_speed(this_host->host));
+            simulation_events++;
+        }
+        
+        disk_write(this_host, this_spill_mb * BYTES_PER_MEGABYTE * compression_ratio);
+    }
+    
+    map_spilled_bytes += output_bytes * compression_ratio;
+    
+    for (i = 0; i < get_merge_passes(spills); i++)
+    {
+        disk_read(this_host, output_bytes * compression_ratio);
+        disk_write(this_host, output_bytes * compression_ratio);
+        map_spilled_bytes += output_bytes * compression_ratio;
+    }
+}
+
+/*
+ * Writes one segment of a reducer's shuffled data to disk
+ */
+static void shuffle_to_disk(struct HdmsgHost *this_host, double *disk_bytes, long *disk_segments, double bytes)
+{
+    disk_write(this_host, bytes);
+    reduce_spilled_bytes += bytes;
+    *disk_bytes += bytes;
+    (*disk_segments)++;
+}
+
+/*
+ * Keeps a shuffled segment in the reducer's buffer of reduce_shuffle_buffer_mb, as Hadoop
+ * does: a segment over shuffle_memory_limit_percent of the buffer goes straight to disk, and
+ * once the buffer is shuffle_merge_percent full its segments are merged into one on disk.
+ */
+void bufferShuffleSegment(struct HdmsgHost *this_host, double *buffered_bytes, double *disk_bytes, long *disk_segments, double bytes)
+{
+    double buffer_bytes = reduce_shuffle_buffer_mb * BYTES_PER_MEGABYTE;
+    
+    if (!disk_enabled())
+    {
+        return;
+    }
+    
+    if (bytes > shuffle_memory_limit_percent * buffer_bytes)
+    {
+        shuffle_to_disk(this_host, disk_bytes, disk_segments, bytes);
+        return;
+    }
+    
+    *buffered_bytes += bytes;
+    
+    // The buffer is emptied before the write blocks, so other copies keep filling it meanwhile
+    if (*buffered_bytes >= shuffle_merge_percent * buffer_bytes)
+    {
+        double merged_bytes = *buffered_bytes;
+        *buffered_bytes = 0;
+        shuffle_to_disk(this_host, disk_bytes, disk_segments, merged_bytes);
+    }
+}
+
+/*
+ * Merges the segments a reducer wrote to disk until one pass is left, then reads them
+ * for the final merge that feeds the reduce
+ */
+void mergeReduceInput(struct HdmsgHost *this_host, double disk_bytes, long disk_segments)
+{
+    long i;
+    
+    if (!disk_enabled() || disk_segments == 0)
+    {
+        return;
+    }
+    
+    for (i = 1; i < get_merge_passes(disk_segments); i++)
+    {
+        disk_read(this_host, disk_bytes);
+        disk_write(this_host, disk_bytes);
+        reduce_spilled_bytes += disk_bytes;
+    }
+    
+    disk_read(this_host, disk_bytes);
+}
+
+/*
+ * Writes a reducer's output, reduce_output_ratio of its uncompressed input
+ */
+void writeReduceOutput(struct HdmsgHost *this_host, double input_bytes)
+{
+    disk_write(this_host, input_bytes * reduce_output_ratio);
+}
+
+void logDiskReport()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    
+    XBT_INFO("Disk: %.0f bytes read, %.0f bytes written, %.0f map and %.0f reduce bytes spilled",
+             disk_bytes_read, disk_bytes_written, map_spilled_bytes, reduce_spilled_bytes);
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            XBT_INFO("%s disk busy %.2f seconds", hdmsg_host->host_name, hdmsg_host->disk_busy_time);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+//
+//  HdmsgDisk.h
+//  HDMSG
+//
+
+#ifndef HDMSGDISK_H
+#define HDMSGDISK_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern double disk_bandwidth;
+extern double io_sort_mb;
+extern double io_sort_spill_percent;
+extern int io_sort_factor;
+extern double sort_cost_per_mb;
+extern double reduce_shuffle_buffer_mb;
+extern double shuffle_memory_limit_percent;
+extern double shuffle_merge_percent;
+extern double reduce_output_ratio;
+
+// Counters, in bytes, like Hadoop's FILE bytes and spilled records
+extern double map_spilled_bytes;
+extern double reduce_spilled_bytes;
+extern double disk_bytes_read;
+extern double disk_bytes_written;
+
+// Defined in HDMSG.c
+extern int BYTES_PER_MEGABYTE;
+extern long simulation_events;
+extern double combiner_ratio;
+extern double compression_ratio;
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+int disk_enabled();
+void assignDiskBandwidths();
+void disk_read(struct HdmsgHost *, double);
+void disk_write(struct HdmsgHost *, double);
+long get_merge_passes(long);
+void spillMapOutput(struct HdmsgHost *, double);
+void bufferShuffleSegment(struct HdmsgHost *, double *, double *, long *, double);
+void mergeReduceInput(struct HdmsgHost *, double, long);
+void writeReduceOutput(struct HdmsgHost *, double);
+void logDiskReport();
+
+// Defined in HDMSG.c
+double get_reference_speed(msg_host_t);
+
+#endif /* HdmsgDisk_h */
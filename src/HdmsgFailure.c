@@ -0,0 +1,802 @@
+//
+//  HdmsgFailure.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HdmsgFailure.h"
+#include "HdmsgSweep.h"
+#include "HdmsgSpeculate.h"
+#include "HdmsgRandom.h"
+#include "HdmsgYarn.h"
+#include "HdmsgMetrics.h"
+#include "HdmsgPool.h"
+#include "HdmsgTopology.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Host crashes: failure_hosts lists "host@seconds" crashes, comma separated. Scenarios are
+// separated by ';', and --failures runs each of them against a run without failures. With
+// failure_mtbf set, every other worker also crashes after an exponentially distributed time
+// with that mean. A crashed host stays down. The master only notices once its NodeManager
+// has been silent for failure_detection_timeout seconds, then runs the host's lost work again.
+char *failure_hosts = NULL;
+double failure_mtbf = 0;
+double failure_detection_timeout = 600;
+
+// Task failures: each map and reduce attempt fails part way through with probability
+// failure_task_probability. A task that fails failure_max_attempts times fails the job, and a
+// host with failure_blacklist_threshold failed attempts gets no more map tasks, as long as
+// under a third of the workers are blacklisted.
+double failure_task_probability = 0;
+int failure_max_attempts = 4;
+int failure_blacklist_threshold = 3;
+
+// Transfers cut off by a crash or by a link going down in the platform's state traces are
+// tried again every failure_retry_interval seconds
+double failure_retry_interval = 10;
+
+struct FailureStats failure_stats;
+
+// One crash of the scenario being simulated
+struct HostCrash
+{
+    struct HdmsgHost *host;
+    double time;
+    struct HdmsgJob *job;       // Whose master notices it
+};
+
+static xbt_dynar_t crashes = NULL;      // struct HostCrash, by time
+static int injecting = 0;               // 0 when the run is the baseline without failures
+
+static int compare_crashes(const void *a, const void *b)
+{
+    const struct HostCrash *x = a;
+    const struct HostCrash *y = b;
+    
+    if (x->time != y->time) { return (x->time < y->time) ? -1 : 1; }
+    return x->host->host_id - y->host->host_id;
+}
+
+/** Number of scenarios in failure_hosts. There is one when only random failures are set. */
+static int count_scenarios()
+{
+    int count = 1;
+    const char *c;
+    
+    for (c = failure_hosts; c != NULL && *c != 0; c++)
+    {
+        count += (*c == ';') ? 1 : 0;
+    }
+    
+    return count;
+}
+
+/** Returns a copy of the crash list of a scenario, from 1, or NULL if it has none */
+static char *get_scenario(int scenario)
+{
+    int i;
+    char *names = NULL;
+    char *cursor_names;
+    char *part = NULL;
+    
+    if (failure_hosts == NULL)
+    {
+        return NULL;
+    }
+    
+    names = xbt_strdup(failure_hosts);
+    cursor_names = names;
+    
+    for (i = 0; i < scenario; i++)
+    {
+        part = strsep(&cursor_names, ";");
+    }
+    
+    part = (part != NULL && *part != 0) ? xbt_strdup(part) : NULL;
+    free(names);
+    
+    return part;
+}
+
+static int is_scheduled(struct HdmsgHost *hdmsg_host)
+{
+    unsigned int cpt;
+    struct HostCrash crash;
+    
+    xbt_dynar_foreach(crashes, cpt, crash)
+    {
+        if (crash.host == hdmsg_host)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ * Lists the crashes of a scenario of failure_hosts, and draws the failure_mtbf crashes.
+ * Scenario 0 is the job without failures.
+ */
+void scheduleFailures(int scenario)
+{
+    int i;
+    struct HostCrash crash;
+    struct HdmsgHost *hdmsg_host;
+    unsigned int cpt;
+    
+    memset(&failure_stats, 0, sizeof(failure_stats));
+    crashes = xbt_dynar_new(sizeof(struct HostCrash), NULL);
+    injecting = (scenario > 0);
+    
+    if (!injecting)
+    {
+        return;
+    }
+    
+    char *names = get_scenario(scenario);
+    char *cursor_names = names;
+    char *name;
+    
+    while (names != NULL && (name = strsep(&cursor_names, ",")) != NULL)
+    {
+        char *at = strchr(name, '@');
+        xbt_assert(at != NULL, "Crash in failure_hosts has no time: %s", name);
+        *at = 0;
+        
+        crash.host = xbt_dict_get_or_null(hosts, name);
+        xbt_assert(crash.host != NULL && crash.host->is_worker && !crash.host->is_master,
+                   "Only workers other than the master can crash: %s", name);
+        xbt_assert(!is_scheduled(crash.host), "%s crashes twice in failure_hosts", name);
+        xbt_assert(sscanf(at + 1, "%lf", &crash.time) == 1 && crash.time >= 0, "Bad crash time in failure_hosts: %s", at + 1);
+        
+        xbt_dynar_push(crashes, &crash);
+    }
+    
+    free(names);
+    
+    if (failure_mtbf > 0)
+    {
+        foreach_hdmsg_host(i, hdmsg_host)
+        {
+            if (hdmsg_host->is_worker && !hdmsg_host->is_master && !is_scheduled(hdmsg_host))
+            {
+                crash.host = hdmsg_host;
+                crash.time = -failure_mtbf * log(1 - random_uniform());
+                xbt_dynar_push(crashes, &crash);
+            }
+        }
+    }
+    
+    if (xbt_dynar_is_empty(crashes))
+    {
+        return;
+    }
+    
+    xbt_dynar_sort(crashes, compare_crashes);
+    
+    xbt_dynar_foreach(crashes, cpt, crash)
+    {
+        XBT_INFO("%s will crash at %.2f", crash.host->host_name, crash.time);
+    }
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        hdmsg_host->pending_transfers = xbt_fifo_new();
+    }
+}
+
+/** Returns 1 if the run injects crashes or task failures, which the master has to handle */
+int failures_enabled()
+{
+    return injecting && (!xbt_dynar_is_empty(crashes) || failure_task_probability > 0);
+}
+
+/** Returns 1 if hosts crash during the run */
+int host_failures_enabled()
+{
+    return injecting && !xbt_dynar_is_empty(crashes);
+}
+
+int countScheduledCrashes()
+{
+    return (crashes != NULL) ? xbt_dynar_length(crashes) : 0;
+}
+
+/*
+ * Marks the job failed and tells the master, which stops the simulation. A task calling
+ * this should not go on.
+ */
+void failJob(struct HdmsgJob *job, const char *reason)
+{
+    if (failure_stats.job_failed)
+    {
+        return;
+    }
+    
+    failure_stats.job_failed = 1;
+    XBT_INFO("The job fails: %s", reason);
+    MSG_task_dsend(MSG_task_create("job_failed", 0, 1, NULL), job->mailbox, NULL);
+}
+
+/** Fails the job from a task, which waits for the master to end the simulation */
+static void fail_job_from_task(struct HdmsgJob *job, const char *reason)
+{
+    failJob(job, reason);
+    MSG_process_suspend(MSG_process_self());
+}
+
+/*
+ * Returns the live, not blacklisted host other than avoid that should run a block's map: the
+ * one that would start it soonest, counting its queued tasks in waves of its map capacity,
+ * then one holding a replica, then the least loaded for its capacity. With running set, only
+ * hosts with a running mapper are considered. NULL if there is none.
+ */
+static struct HdmsgHost *pick_map_host(struct HdmsgJob *job, struct HdfsBlock *block, struct HdmsgHost *avoid, int running)
+{
+    int i;
+    struct HdmsgHost *hdmsg_host;
+    struct HdmsgHost *best = NULL;
+    int best_local = 0;
+    double best_capacity = 0;
+    double best_wave = 0;
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        struct HdmsgJobHost *job_host = get_job_host(job, hdmsg_host);
+        
+        if (!hdmsg_host->is_worker || hdmsg_host->failed || hdmsg_host->blacklisted || hdmsg_host == avoid ||
+            (running && job_host->active_mappers == 0))
+        {
+            continue;
+        }
+        
+        int local = holds_replica(block, hdmsg_host);
+        double capacity = get_capacity(hdmsg_host, get_map_slots(hdmsg_host));
+        double wave = floor(xbt_fifo_size(job_host->map_tasks) / capacity);
+        
+        if (best == NULL || wave < best_wave || (wave == best_wave && (local > best_local ||
+            (local == best_local && xbt_fifo_size(job_host->map_tasks) * best_capacity < xbt_fifo_size(get_job_host(job, best)->map_tasks) * capacity))))
+        {
+            best = hdmsg_host;
+            best_local = local;
+            best_capacity = capacity;
+            best_wave = wave;
+        }
+    }
+    
+    return best;
+}
+
+/*
+ * Returns the live worker with the fewest reducers, preferring hosts that are not
+ * blacklisted, or NULL if every worker crashed
+ */
+static struct HdmsgHost *pick_live_worker(struct HdmsgJob *job)
+{
+    int i;
+    struct HdmsgHost *hdmsg_host;
+    struct HdmsgHost *best = NULL;
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        if (!hdmsg_host->is_worker || hdmsg_host->failed)
+        {
+            continue;
+        }
+        
+        if (best == NULL || hdmsg_host->blacklisted < best->blacklisted ||
+            (hdmsg_host->blacklisted == best->blacklisted &&
+             get_reducer_count(get_job_host(job, hdmsg_host)) < get_reducer_count(get_job_host(job, best))))
+        {
+            best = hdmsg_host;
+        }
+    }
+    
+    return best;
+}
+
+/** Queues a block's map on another host, which reads the block from there */
+static void move_map_task(struct HdmsgJobHost *target, struct HdfsBlock *block)
+{
+    map_locality[block->locality]--;
+    set_block_reader(block, target->host);
+    map_locality[block->locality]++;
+    
+    xbt_fifo_push(target->map_tasks, block);
+}
+
+/*
+ * Stops giving a host map tasks once too many of its attempts failed. Its queued tasks move to
+ * hosts that still take work, and stay if there are none.
+ */
+static void blacklist_host(struct HdmsgJob *job, struct HdmsgHost *this_host)
+{
+    struct HdfsBlock *block;
+    struct HdmsgJobHost *job_host = get_job_host(job, this_host);
+    xbt_fifo_t kept = xbt_fifo_new();
+    
+    this_host->blacklisted = 1;
+    failure_stats.blacklisted_hosts++;
+    XBT_INFO("%s is blacklisted after %d failed attempts", this_host->host_name, this_host->failed_attempts);
+    
+    while ((block = xbt_fifo_shift(job_host->map_tasks)) != NULL)
+    {
+        struct HdmsgHost *target = pick_map_host(job, block, NULL, 1);
+        
+        if (target != NULL)
+        {
+            move_map_task(get_job_host(job, target), block);
+        }
+        else
+        {
+            xbt_fifo_push(kept, block);
+        }
+    }
+    
+    xbt_fifo_free(job_host->map_tasks);
+    job_host->map_tasks = kept;
+}
+
+/*
+ * Decides whether a task attempt of the given cost fails. A failed attempt runs for a random
+ * part of the cost first. Returns 1 if it failed.
+ */
+int failAttempt(struct HdmsgJob *job, struct HdmsgHost *this_host, double cost, const char *name)
+{
+    if (failure_task_probability <= 0 || !injecting || random_uniform() >= failure_task_probability)
+    {
+        return 0;
+    }
+    
+    double start_time = MSG_get_clock();
+    execute_task(name, random_uniform() * cost * this_host->slowdown);
+    simulation_events++;
+    
+    this_host->busy_time += MSG_get_clock() - start_time;
+    METRICS_BUSY(this_host, start_time);
+    
+    failure_stats.failed_attempts++;
+    failure_stats.wasted_time += MSG_get_clock() - start_time;
+    XBT_INFO("%s failed a %s attempt", MSG_process_get_name(MSG_process_self()), name);
+    
+    this_host->failed_attempts++;
+    
+    // Like the MapReduce AM, blacklisting stops short of a third of the workers
+    if (failure_blacklist_threshold > 0 && this_host->failed_attempts == failure_blacklist_threshold &&
+        3 * (failure_stats.blacklisted_hosts + 1) <= number_of_workers)
+    {
+        blacklist_host(job, this_host);
+    }
+    
+    return 1;
+}
+
+/*
+ * Schedules a map again after a failed attempt, on another host with a running mapper if
+ * there is one, like the MapReduce AM. Otherwise this host runs it after its other queued
+ * tasks.
+ */
+void retryMapTask(struct HdmsgJobHost *this_host, struct HdfsBlock *block)
+{
+    struct HdmsgJob *job = this_host->job;
+    
+    block->map_host = NULL;
+    
+    if (++block->attempts >= failure_max_attempts)
+    {
+        fail_job_from_task(job, intern_name("the map of block %ld failed %d times", block->block_id, block->attempts));
+        return;
+    }
+    
+    struct HdmsgHost *target = pick_map_host(job, block, this_host->host, 1);
+    
+    if (target == NULL)
+    {
+        // map() takes the last queued task next
+        xbt_fifo_unshift(this_host->map_tasks, block);
+    }
+    else
+    {
+        move_map_task(get_job_host(job, target), block);
+    }
+}
+
+/** Counts a failed reduce attempt, which its reducer runs again */
+void retryReduceTask(struct HdmsgReducer *reducer)
+{
+    if (++reducer->attempts >= failure_max_attempts)
+    {
+        fail_job_from_task(reducer->job, intern_name("reducer %ld failed %d times", reducer->partition, reducer->attempts));
+    }
+}
+
+/** Waits before a transfer cut off by a failure is tried again */
+void waitToRetry()
+{
+    failure_stats.transfer_retries++;
+    MSG_process_sleep(failure_retry_interval);
+    simulation_events++;
+}
+
+/*
+ * Called when reading a block failed. The HDFS client moves on to another replica when the
+ * source crashed, and waits for a link to come back otherwise.
+ */
+void retryBlockRead(struct HdmsgJob *job, struct HdfsBlock *block, struct HdmsgHost *this_host)
+{
+    if (!block->source->failed)
+    {
+        waitToRetry();
+        return;
+    }
+    
+    failure_stats.transfer_retries++;
+    
+    map_locality[block->locality]--;
+    set_block_reader(block, this_host);
+    map_locality[block->locality]++;
+    
+    if (block->source != NULL && block->source->failed)
+    {
+        fail_job_from_task(job, intern_name("every replica of block %ld is lost", block->block_id));
+    }
+}
+
+/*
+ * Called when fetching a map output failed. Returns 1 to fetch it again, or 0 once its host
+ * is lost, as the map's next run writes it again.
+ */
+int retryMapOutput(struct HdmsgReducer *reducer, struct MapOutput *output)
+{
+    if (!output->host->lost)
+    {
+        waitToRetry();
+    }
+    
+    if (output->host->lost)
+    {
+        reducer->fetched_blocks[output->block->block_id] = FETCH_NONE;
+        return 0;
+    }
+    
+    return 1;
+}
+
+/** Remembers a transfer a DataNode on the source has not started sending, when hosts can crash */
+void watch_transfer(struct HdmsgHost *source, msg_task_t transfer)
+{
+    if (source->pending_transfers != NULL)
+    {
+        xbt_fifo_push(source->pending_transfers, transfer);
+    }
+}
+
+void unwatch_transfer(struct HdmsgHost *source, msg_task_t transfer)
+{
+    if (source->pending_transfers != NULL)
+    {
+        xbt_fifo_remove(source->pending_transfers, transfer);
+    }
+}
+
+/*
+ * Turns a host off, which kills its processes. Readers waiting for a DataNode that died
+ * before it started sending are told the host is gone.
+ */
+static void crash_host(struct HdmsgHost *crashed_host)
+{
+    xbt_fifo_item_t bucket;
+    msg_task_t transfer;
+    
+    XBT_INFO("%s has crashed", crashed_host->host_name);
+    crashed_host->failed = 1;
+    failure_stats.crashed_hosts++;
+    MSG_host_off(crashed_host->host);
+    
+    xbt_fifo_foreach(crashed_host->pending_transfers, bucket, transfer, msg_task_t)
+    {
+        MSG_task_dsend(MSG_task_create("host_failed", 0, 0, NULL), MSG_task_get_name(transfer), NULL);
+    }
+}
+
+/** Failure Injector Process: crashes one host, and tells the master once it would notice */
+int failureInjector(int argc, char * argv[])
+{
+    struct HostCrash *crash = MSG_process_get_data(MSG_process_self());
+    
+    if (crash->time > MSG_get_clock())
+    {
+        MSG_process_sleep(crash->time - MSG_get_clock());
+        simulation_events++;
+    }
+    
+    crash_host(crash->host);
+    
+    // The NodeManager's heartbeats stop, and the master waits for them to expire
+    MSG_process_sleep(failure_detection_timeout);
+    simulation_events++;
+    
+    MSG_task_dsend(MSG_task_create("host_lost", 0, 1, crash->host), crash->job->mailbox, NULL);
+    
+    return 0;
+}
+
+/** Starts one injector per scheduled crash on the master's host, which never crashes */
+void startFailureInjector(struct HdmsgJob *job, struct HdmsgHost *this_host)
+{
+    unsigned int cpt;
+    
+    for (cpt = 0; cpt < xbt_dynar_length(crashes); cpt++)
+    {
+        struct HostCrash *crash = xbt_dynar_get_ptr(crashes, cpt);
+        crash->job = job;
+        MSG_process_create(intern_name("Failure-%s", crash->host->host_name), failureInjector, crash, this_host->host);
+    }
+}
+
+/*
+ * Returns 1 if some reducer has not fetched a block's map output yet, or may copy it again
+ * after a failed attempt
+ */
+static int output_needed(struct HdmsgJob *job, struct HdfsBlock *block)
+{
+    long i;
+    
+    for (i = 0; i < job->reducer_table_size; i++)
+    {
+        struct HdmsgReducer *reducer = job->reducer_table[i];
+        
+        if (reducer->fetched_blocks[block->block_id] != FETCH_DONE ||
+            (failure_task_probability > 0 && reducer->finish_time <= 0))
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ * Queues a block's map on a live worker, spreading the maps run again over the workers by
+ * their map capacity. A worker whose mappers have exited starts new ones for its queued
+ * tasks, up to its map slots, counted in added.
+ */
+static void requeue_map(struct HdmsgJob *job, struct HdfsBlock *block, long *added)
+{
+    struct HdmsgHost *target_host = pick_map_host(job, block, NULL, 0);
+    
+    // Only blacklisted workers are left
+    if (target_host == NULL)
+    {
+        target_host = pick_live_worker(job);
+    }
+    
+    if (target_host == NULL)
+    {
+        failJob(job, "every worker has crashed");
+        return;
+    }
+    
+    struct HdmsgJobHost *target = get_job_host(job, target_host);
+    
+    // A completed map counted once already
+    if (!block->mapped)
+    {
+        map_locality[block->locality]--;
+    }
+    
+    block->map_host = NULL;
+    block->mapped = 0;
+    set_block_reader(block, target_host);
+    map_locality[block->locality]++;
+    
+    xbt_fifo_push(target->map_tasks, block);
+    
+    while (job->mappers_launched && target->active_mappers < get_map_slots(target_host) &&
+           target->active_mappers < xbt_fifo_size(target->map_tasks))
+    {
+        createMapper(target);
+        added[0]++;
+    }
+}
+
+/*
+ * Runs in the master once it notices a crash. The master stands in for the processes that
+ * died with the host, its unfinished reducers start over on live hosts, and the maps it was
+ * to run, was running or whose output a reducer still needs run again. added counts the
+ * mappers, fetchers and reducers started, which report to the master.
+ */
+void recoverLostHost(struct HdmsgJob *job, struct HdmsgHost *lost_host, long *added)
+{
+    long i, j;
+    struct HdfsBlock *block;
+    struct HdmsgJobHost *lost = get_job_host(job, lost_host);
+    
+    lost_host->lost = 1;
+    failure_stats.lost_hosts++;
+    XBT_INFO("%s is lost, its tasks run again", lost_host->host_name);
+    
+    for (i = lost->reported_mappers; i < get_mapper_count(lost); i++)
+    {
+        MSG_task_dsend(MSG_task_create("map_exit", 0, 1, NULL), job->mailbox, NULL);
+    }
+    
+    for (i = lost->reported_shufflers; i < get_shuffler_count(lost); i++)
+    {
+        MSG_task_dsend(MSG_task_create("shuffle_exit", 0, 1, NULL), job->mailbox, NULL);
+    }
+    
+    for (i = lost->reported_reducers; i < get_reducer_count(lost); i++)
+    {
+        MSG_task_dsend(MSG_task_create("reduce_exit", 0, 1, NULL), job->mailbox, NULL);
+    }
+    
+    for (i = 0; i < job->reducer_table_size; i++)
+    {
+        struct HdmsgReducer *reducer = job->reducer_table[i];
+        
+        if (reducer->host != lost_host || reducer->finish_time > 0)
+        {
+            continue;
+        }
+        
+        struct HdmsgHost *target = pick_live_worker(job);
+        
+        if (target == NULL)
+        {
+            failJob(job, "every worker has crashed");
+            return;
+        }
+        
+        job->reducer_table[i] = createReducer(job, target, reducer->partition);
+        failure_stats.relaunched_reduces++;
+        added[1] += xbt_fifo_size(job->reducer_table[i]->receivers);
+        added[2]++;
+        XBT_INFO("Reducer %ld starts over on %s", reducer->partition, target->host_name);
+        
+        // Its fetchers go through every map output written so far
+        for (j = 0; j < xbt_dynar_length(job->map_outputs); j++)
+        {
+            MSG_sem_release(job->reducer_table[i]->fetch_work);
+        }
+    }
+    
+    while ((block = xbt_fifo_shift(lost->map_tasks)) != NULL)
+    {
+        requeue_map(job, block, added);
+    }
+    
+    for (i = 0; i < job->map_tasks; i++)
+    {
+        block = job->blocks[i];
+        
+        if (block->map_host == lost_host && (!block->mapped || output_needed(job, block)))
+        {
+            failure_stats.rerun_maps++;
+            requeue_map(job, block, added);
+        }
+    }
+}
+
+void logFailureReport(struct FailureStats *stats)
+{
+    XBT_INFO("Failures: %d hosts crashed (%d noticed), %d blacklisted, %ld failed attempts wasting %.2f seconds",
+             stats->crashed_hosts,
+             stats->lost_hosts,
+             stats->blacklisted_hosts,
+             stats->failed_attempts,
+             stats->wasted_time);
+    XBT_INFO("Recovery: %ld maps run again, %ld reducers relaunched, %ld transfers retried%s",
+             stats->rerun_maps,
+             stats->relaunched_reduces,
+             stats->transfer_retries,
+             stats->job_failed ? ", the job failed" : "");
+}
+
+/*
+ * Simulates the job without failures and with each failure scenario, and reports how much
+ * longer each scenario takes and how much throughput it loses. Results also go to
+ * HDMSG_failures.txt.
+ */
+int runFailures(double map_cf, double reduce_cf)
+{
+    int i;
+    int scenarios = count_scenarios();
+    struct SimResult *results = xbt_new0(struct SimResult, scenarios + 1);
+    
+    // Every scenario runs with the seed of the baseline, so only the failures differ
+    for (i = 0; i <= scenarios; i++)
+    {
+        initSimResult(&results[i], map_cf, reduce_cf);
+        results[i].failure_scenario = i;
+    }
+    
+    runParallel(results, scenarios + 1, get_worker_count(sweep_workers), runSimulation);
+    
+    if (results[0].status != 0)
+    {
+        fprintf(stderr, "The simulation without failures failed.\n");
+        free(results);
+        return 1;
+    }
+    
+    FILE * output_file = fopen("HDMSG_failures.txt", "w");
+    
+    if (output_file == NULL)
+    {
+        fprintf(stderr, "Error while opening HDMSG_failures.txt.\n");
+        free(results);
+        return 1;
+    }
+    
+    double baseline_time = results[0].simulation_time;
+    double baseline_throughput = input_size / baseline_time;
+    
+    fprintf(output_file, "scenario makespan throughput latency_penalty throughput_penalty crashed_hosts lost_hosts blacklisted_hosts failed_attempts rerun_maps relaunched_reduces transfer_retries wasted_time job_failed\n");
+    printf("\nScenario\t\tMakespan\tThroughput\tLatency Penalty\tThroughput Penalty\n");
+    printf("No failures: %19.2f %10.2f MB/s\n", baseline_time, baseline_throughput);
+    
+    for (i = 0; i <= scenarios; i++)
+    {
+        struct SimResult *result = &results[i];
+        struct FailureStats *stats = &result->failures;
+        int completed = (result->status == 0);
+        double throughput = completed ? input_size / result->simulation_time : 0;
+        double latency_penalty = completed ? 100 * (result->simulation_time - baseline_time) / baseline_time : 0;
+        double throughput_penalty = 100 * (baseline_throughput - throughput) / baseline_throughput;
+        
+        fprintf(output_file, "%d %.2f %.2f %.2f %.2f %d %d %d %ld %ld %ld %ld %.2f %d\n",
+                i,
+                completed ? result->simulation_time : 0,
+                throughput,
+                latency_penalty,
+                throughput_penalty,
+                stats->crashed_hosts,
+                stats->lost_hosts,
+                stats->blacklisted_hosts,
+                stats->failed_attempts,
+                stats->rerun_maps,
+                stats->relaunched_reduces,
+                stats->transfer_retries,
+                stats->wasted_time,
+                !completed);
+        
+        if (i == 0)
+        {
+            continue;
+        }
+        
+        char *crash_list = get_scenario(i);
+        
+        if (completed)
+        {
+            printf("Scenario %d: %20.2f %10.2f MB/s %12.2f%% %16.2f%%\n", i, result->simulation_time, throughput, latency_penalty, throughput_penalty);
+        }
+        else
+        {
+            printf("Scenario %d: %20s\n", i, "job failed");
+        }
+        
+        printf("    crashes: %s, %d crashed, %d blacklisted, %ld failed attempts, %ld maps run again, %ld reducers relaunched, %ld transfers retried\n",
+               (crash_list != NULL) ? crash_list : "none listed",
+               stats->crashed_hosts,
+               stats->blacklisted_hosts,
+               stats->failed_attempts,
+               stats->rerun_maps,
+               stats->relaunched_reduces,
+               stats->transfer_retries);
+        
+        free(crash_list);
+    }
+    
+    printf("\n");
+    fclose(output_file);
+    free(results);
+    
+    return 0;
+}
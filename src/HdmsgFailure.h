@@ -0,0 +1,82 @@
+//
+//  HdmsgFailure.h
+//  HDMSG
+//
+
+#ifndef HDMSGFAILURE_H
+#define HDMSGFAILURE_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+#include "HdmsgHdfs.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern char *failure_hosts;
+extern double failure_mtbf;
+extern double failure_detection_timeout;
+extern double failure_task_probability;
+extern int failure_max_attempts;
+extern int failure_blacklist_threshold;
+extern double failure_retry_interval;
+
+extern struct FailureStats failure_stats;
+
+// Defined in HDMSG.c
+extern long simulation_events;
+extern long input_size;
+extern struct HdmsgHost *master_host;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// What the injected failures cost one run
+struct FailureStats
+{
+    int crashed_hosts;
+    int lost_hosts;             // Crashes the master noticed before the job ended
+    int blacklisted_hosts;
+    long failed_attempts;       // Map and reduce attempts that failed on their own
+    long rerun_maps;            // Maps run again because their host or output was lost
+    long relaunched_reduces;
+    long transfer_retries;      // Block reads and shuffle copies tried again
+    double wasted_time;         // Task seconds spent on failed attempts
+    int job_failed;
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void scheduleFailures(int);
+int failures_enabled();
+int host_failures_enabled();
+void logFailureReport(struct FailureStats *);
+int runFailures(double, double);
+
+int failAttempt(struct HdmsgJob *, struct HdmsgHost *, double, const char *);
+void retryMapTask(struct HdmsgJobHost *, struct HdfsBlock *);
+void retryReduceTask(struct HdmsgReducer *);
+void waitToRetry();
+void retryBlockRead(struct HdmsgJob *, struct HdfsBlock *, struct HdmsgHost *);
+int retryMapOutput(struct HdmsgReducer *, struct MapOutput *);
+void failJob(struct HdmsgJob *, const char *);
+
+void watch_transfer(struct HdmsgHost *, msg_task_t);
+void unwatch_transfer(struct HdmsgHost *, msg_task_t);
+
+void startFailureInjector(struct HdmsgJob *, struct HdmsgHost *);
+int countScheduledCrashes();
+void recoverLostHost(struct HdmsgJob *, struct HdmsgHost *, long *);
+
+int failureInjector(int argc, char * argv[]);
+
+// Defined in HDMSG.c
+msg_process_t createMapper(struct HdmsgJobHost *);
+struct HdmsgReducer *createReducer(struct HdmsgJob *, struct HdmsgHost *, long);
+
+#endif /* HdmsgFailure_h */
@@ -0,0 +1,276 @@
+//
+//  HdmsgGroundTruth.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HdmsgGroundTruth.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Runs measured on the cluster, one line per run, generated by importGroundTruth.py.
+// Only the runs of ground_truth_platform are loaded, which defaults to the name of the
+// platform file without .xml.
+char *ground_truth_file = "groundTruth.txt";
+char *ground_truth_platform = NULL;
+
+// Columns a ground truth file must have, found by name in its header line
+#define GROUND_TRUTH_COLUMNS 7
+static const char *column_names[GROUND_TRUTH_COLUMNS] = {
+    "platform", "input_mb", "chunk_mb", "reducers", "map_s", "reduce_s", "exec_s"
+};
+enum { COLUMN_PLATFORM, COLUMN_INPUT, COLUMN_CHUNK, COLUMN_REDUCERS, COLUMN_MAP, COLUMN_REDUCE, COLUMN_EXEC };
+
+// Longest ground truth line, and most columns on one
+#define GROUND_TRUTH_LINE_SIZE 1024
+#define GROUND_TRUTH_MAX_FIELDS 64
+
+static xbt_dict_t ground_truth;             // struct GroundTruth * by "input-chunk-reducers"
+static struct GroundTruth **measured;       // The same entries, by input, chunk and reducers
+static int measured_count;
+
+static const char *get_key(long input_mb, long chunk_mb, long reducer_count)
+{
+    static char key[64];
+    snprintf(key, sizeof(key), "%ld-%ld-%ld", input_mb, chunk_mb, reducer_count);
+    return key;
+}
+
+static int compare_configs(const void *a, const void *b)
+{
+    const struct GroundTruth *x = *(struct GroundTruth * const *) a;
+    const struct GroundTruth *y = *(struct GroundTruth * const *) b;
+    
+    if (x->input_size != y->input_size) { return (x->input_size < y->input_size) ? -1 : 1; }
+    if (x->hdfs_chunk_size != y->hdfs_chunk_size) { return (x->hdfs_chunk_size < y->hdfs_chunk_size) ? -1 : 1; }
+    if (x->reducers != y->reducers) { return (x->reducers < y->reducers) ? -1 : 1; }
+    return 0;
+}
+
+/*
+ * Splits a line on spaces and tabs and returns the number of fields
+ */
+static int split_fields(char *line, char **fields)
+{
+    int count = 0;
+    char *field = strtok(line, " \t\r\n");
+    
+    while (field != NULL && count < GROUND_TRUTH_MAX_FIELDS)
+    {
+        fields[count++] = field;
+        field = strtok(NULL, " \t\r\n");
+    }
+    
+    return count;
+}
+
+/** Adds one run to the running means of its configuration and returns that configuration */
+static struct GroundTruth *add_run(char **fields, int *columns, int elapsed_column, int shuffle_column, int spilled_column)
+{
+    long input_mb = atol(fields[columns[COLUMN_INPUT]]);
+    long chunk_mb = atol(fields[columns[COLUMN_CHUNK]]);
+    long reducer_count = atol(fields[columns[COLUMN_REDUCERS]]);
+    const char *key = get_key(input_mb, chunk_mb, reducer_count);
+    
+    struct GroundTruth *entry = xbt_dict_get_or_null(ground_truth, key);
+    
+    if (entry == NULL)
+    {
+        entry = xbt_new0(struct GroundTruth, 1);
+        entry->input_size = input_mb;
+        entry->hdfs_chunk_size = chunk_mb;
+        entry->reducers = reducer_count;
+        xbt_dict_set(ground_truth, key, entry, NULL);
+    }
+    
+    entry->runs++;
+    entry->map_time += (atof(fields[columns[COLUMN_MAP]]) - entry->map_time) / entry->runs;
+    entry->reduce_time += (atof(fields[columns[COLUMN_REDUCE]]) - entry->reduce_time) / entry->runs;
+    entry->exec_time += (atof(fields[columns[COLUMN_EXEC]]) - entry->exec_time) / entry->runs;
+    
+    // Logs that stop before the job reports completion have no elapsed time or counters
+    if (elapsed_column >= 0 && strcmp(fields[elapsed_column], "-") != 0)
+    {
+        entry->completed_runs++;
+        entry->elapsed_time += (atof(fields[elapsed_column]) - entry->elapsed_time) / entry->completed_runs;
+        
+        if (shuffle_column >= 0)
+        {
+            entry->shuffle_bytes += (atof(fields[shuffle_column]) - entry->shuffle_bytes) / entry->completed_runs;
+        }
+        
+        if (spilled_column >= 0)
+        {
+            entry->spilled_records += (atof(fields[spilled_column]) - entry->spilled_records) / entry->completed_runs;
+        }
+    }
+    
+    return entry;
+}
+
+/*
+ * Reads the cluster runs of the simulated platform into the ground truth store. Without a
+ * ground truth file every configuration is simulated without validation.
+ */
+void loadGroundTruth(const char *platform_path)
+{
+    char line[GROUND_TRUTH_LINE_SIZE];
+    char *fields[GROUND_TRUTH_MAX_FIELDS];
+    int columns[GROUND_TRUTH_COLUMNS];
+    int elapsed_column = -1, shuffle_column = -1, spilled_column = -1;
+    int header_fields = 0;
+    int line_number = 0;
+    int runs = 0;
+    int i;
+    
+    ground_truth = xbt_dict_new();
+    measured_count = 0;
+    
+    if (ground_truth_platform == NULL)
+    {
+        const char *name = strrchr(platform_path, '/');
+        ground_truth_platform = xbt_strdup((name != NULL) ? name + 1 : platform_path);
+        
+        char *extension = strrchr(ground_truth_platform, '.');
+        if (extension != NULL && strcmp(extension, ".xml") == 0) { *extension = 0; }
+    }
+    
+    FILE * truth_file = fopen(ground_truth_file, "r");
+    
+    if (truth_file == NULL)
+    {
+        XBT_INFO("No ground truth file %s, results will not be validated", ground_truth_file);
+        return;
+    }
+    
+    xbt_dynar_t entries = xbt_dynar_new(sizeof(struct GroundTruth *), NULL);
+    
+    while (fgets(line, sizeof(line), truth_file) != NULL)
+    {
+        line_number++;
+        
+        if (line[0] == '#')
+        {
+            continue;
+        }
+        
+        int count = split_fields(line, fields);
+        
+        if (count == 0)
+        {
+            continue;
+        }
+        
+        // The first line that is not a comment names the columns
+        if (header_fields == 0)
+        {
+            for (i = 0; i < GROUND_TRUTH_COLUMNS; i++)
+            {
+                int j;
+                columns[i] = -1;
+                
+                for (j = 0; j < count; j++)
+                {
+                    if (strcmp(fields[j], column_names[i]) == 0) { columns[i] = j; }
+                }
+                
+                if (columns[i] < 0)
+                {
+                    fprintf(stderr, "Error in ground truth file %s, line %d: no %s column\n",
+                            ground_truth_file, line_number, column_names[i]);
+                    exit(1);
+                }
+            }
+            
+            for (i = 0; i < count; i++)
+            {
+                if (strcmp(fields[i], "elapsed_s") == 0) { elapsed_column = i; }
+                if (strcmp(fields[i], "shuffle_bytes") == 0) { shuffle_column = i; }
+                if (strcmp(fields[i], "spilled_records") == 0) { spilled_column = i; }
+            }
+            
+            header_fields = count;
+            continue;
+        }
+        
+        if (count != header_fields)
+        {
+            fprintf(stderr, "Error in ground truth file %s, line %d: expected %d columns, found %d\n",
+                    ground_truth_file, line_number, header_fields, count);
+            exit(1);
+        }
+        
+        if (strcmp(fields[columns[COLUMN_PLATFORM]], ground_truth_platform) != 0)
+        {
+            continue;
+        }
+        
+        struct GroundTruth *entry = add_run(fields, columns, elapsed_column, shuffle_column, spilled_column);
+        runs++;
+        
+        if (entry->runs == 1)
+        {
+            xbt_dynar_push(entries, &entry);
+        }
+    }
+    
+    fclose(truth_file);
+    
+    measured_count = xbt_dynar_length(entries);
+    measured = xbt_dynar_to_array(entries);
+    qsort(measured, measured_count, sizeof(struct GroundTruth *), compare_configs);
+    
+    XBT_INFO("Ground truth: %d runs of %d configurations measured on %s", runs, measured_count, ground_truth_platform);
+}
+
+/** Returns the cluster measurements of a configuration, or NULL if it was never run on the cluster */
+struct GroundTruth *getGroundTruth(long input_mb, long chunk_mb, long reducer_count)
+{
+    if (ground_truth == NULL) { return NULL; }
+    
+    return xbt_dict_get_or_null(ground_truth, get_key(input_mb, chunk_mb, reducer_count));
+}
+
+/*
+ * Looks up the times measured on the cluster for a configuration.
+ * Returns 0 if that configuration was never run on the cluster.
+ */
+int getActualTimes(long input_mb, long chunk_mb, long reducer_count, double *actual_map, double *actual_reduce, double *actual_exec)
+{
+    struct GroundTruth *entry = getGroundTruth(input_mb, chunk_mb, reducer_count);
+    
+    if (entry == NULL) { return 0; }
+    
+    *actual_map = entry->map_time;
+    *actual_reduce = entry->reduce_time;
+    *actual_exec = entry->exec_time;
+    
+    return 1;
+}
+
+/** Number of configurations with cluster measurements on the simulated platform */
+int getMeasuredConfigCount()
+{
+    return measured_count;
+}
+
+/*
+ * Fills configs, which holds getMeasuredConfigCount() entries, with every configuration
+ * that has cluster measurements and returns how many there are
+ */
+int getMeasuredConfigs(struct SimResult *configs, double map_cf, double reduce_cf)
+{
+    int i;
+    
+    for (i = 0; i < measured_count; i++)
+    {
+        initSimResult(&configs[i], map_cf, reduce_cf);
+        configs[i].input_size = measured[i]->input_size;
+        configs[i].hdfs_chunk_size = measured[i]->hdfs_chunk_size;
+        configs[i].reducers = measured[i]->reducers;
+    }
+    
+    return measured_count;
+}
@@ -0,0 +1,52 @@
+//
+//  HdmsgGroundTruth.h
+//  HDMSG
+//
+
+#ifndef HDMSGGROUNDTRUTH_H
+#define HDMSGGROUNDTRUTH_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgSweep.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern char *ground_truth_file;
+extern char *ground_truth_platform;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// Mean of the cluster runs of one configuration on one platform, written by importGroundTruth.py
+struct GroundTruth
+{
+    long input_size;        // In MB
+    long hdfs_chunk_size;   // In MB
+    long reducers;
+    
+    int runs;
+    double map_time;        // First progress line to map 100%
+    double reduce_time;     // Map 100% to reduce 100%
+    double exec_time;       // map_time + reduce_time
+    
+    int completed_runs;     // Runs whose log reaches "completed successfully", averaged below
+    double elapsed_time;    // Submission to completion
+    double shuffle_bytes;
+    double spilled_records;
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void loadGroundTruth(const char *);
+struct GroundTruth *getGroundTruth(long, long, long);
+int getActualTimes(long, long, long, double *, double *, double *);
+int getMeasuredConfigCount();
+int getMeasuredConfigs(struct SimResult *, double, double);
+
+#endif /* HdmsgGroundTruth_h */
@@ -0,0 +1,616 @@
+//
+//  HdmsgHdfs.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HdmsgHdfs.h"
+#include "HdmsgRandom.h"
+#include "HdmsgYarn.h"
+#include "HdmsgDisk.h"
+#include "HdmsgMetrics.h"
+#include "HdmsgPool.h"
+#include "HdmsgFailure.h"
+#include "HdmsgTopology.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Replicas per block and where they go:
+// "rack_aware" puts the first replica on the writer, the second on another rack and the rest
+//     next to the second, as HDFS does. Writers take turns over the workers, each as often
+//     as its share of the map capacity.
+// "random" puts every replica on a random worker.
+// "pinned" takes turns over the comma separated workers in hdfs_pinned_hosts only.
+int hdfs_replication = 1;
+char *hdfs_placement = "rack_aware";
+char *hdfs_pinned_hosts = NULL;
+
+long map_locality[3];
+
+// Work stealing: a host out of map tasks takes one from the host with the most left, once it
+// has waited locality_delay seconds for local work, like YARN's delay scheduling.
+int work_stealing = 0;
+double locality_delay = 0;
+long stolen_maps = 0;
+
+// Names each transfer's mailbox, so a late failure notice cannot reach a later transfer
+static long next_transfer = 0;
+
+int holds_replica(struct HdfsBlock *block, struct HdmsgHost *hdmsg_host)
+{
+    int i;
+    
+    for (i = 0; i < block->replica_count; i++)
+    {
+        if (block->replicas[i] == hdmsg_host)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ * Returns the workers blocks may be placed on, in dict order, or the pinned hosts
+ */
+static xbt_dynar_t get_datanodes()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    xbt_dynar_t datanodes = xbt_dynar_new(sizeof(struct HdmsgHost *), NULL);
+    
+    if (strcmp(hdfs_placement, "pinned") == 0)
+    {
+        xbt_assert(hdfs_pinned_hosts != NULL, "Pinned HDFS placement needs hdfs_pinned_hosts");
+        
+        char *names = xbt_strdup(hdfs_pinned_hosts);
+        char *cursor_names = names;
+        char *name;
+        
+        while ((name = strsep(&cursor_names, ",")) != NULL)
+        {
+            hdmsg_host = xbt_dict_get_or_null(hosts, name);
+            xbt_assert(hdmsg_host != NULL && hdmsg_host->is_worker, "Pinned HDFS host is not a worker: %s", name);
+            xbt_dynar_push(datanodes, &hdmsg_host);
+        }
+        
+        free(names);
+        return datanodes;
+    }
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            xbt_dynar_push(datanodes, &hdmsg_host);
+        }
+    }
+    
+    return datanodes;
+}
+
+/*
+ * Picks a random datanode that holds no replica of the block yet. With rack set, the
+ * datanode must be on that rack (same = 1) or off it (same = 0), if one exists.
+ */
+static struct HdmsgHost *pick_datanode(xbt_dynar_t datanodes, struct HdfsBlock *block, struct HdmsgHost *rack, int same)
+{
+    unsigned int cpt;
+    struct HdmsgHost *hdmsg_host;
+    xbt_dynar_t candidates = xbt_dynar_new(sizeof(struct HdmsgHost *), NULL);
+    
+    xbt_dynar_foreach(datanodes, cpt, hdmsg_host)
+    {
+        if (!holds_replica(block, hdmsg_host) && (rack == NULL || same_rack(hdmsg_host, rack) == same))
+        {
+            xbt_dynar_push(candidates, &hdmsg_host);
+        }
+    }
+    
+    // Fall back to any datanode when the rack constraint cannot be met
+    if (xbt_dynar_is_empty(candidates) && rack != NULL)
+    {
+        xbt_dynar_free(&candidates);
+        return pick_datanode(datanodes, block, NULL, 0);
+    }
+    
+    hdmsg_host = NULL;
+    if (!xbt_dynar_is_empty(candidates))
+    {
+        hdmsg_host = xbt_dynar_get_as(candidates, random_below(xbt_dynar_length(candidates)), struct HdmsgHost *);
+    }
+    
+    xbt_dynar_free(&candidates);
+    return hdmsg_host;
+}
+
+/*
+ * Picks the writer of the next block, in smooth weighted round-robin order: every datanode
+ * earns its capacity in credit each turn, and the one with the most credit writes the block
+ * and pays the total back. A host's turns are spread out, and equal hosts take plain turns.
+ */
+static struct HdmsgHost *next_writer(xbt_dynar_t datanodes, double *capacities, double *credits)
+{
+    unsigned int cpt;
+    unsigned int best = 0;
+    double total_capacity = 0;
+    
+    for (cpt = 0; cpt < xbt_dynar_length(datanodes); cpt++)
+    {
+        credits[cpt] += capacities[cpt];
+        total_capacity += capacities[cpt];
+        
+        if (credits[cpt] > credits[best])
+        {
+            best = cpt;
+        }
+    }
+    
+    credits[best] -= total_capacity;
+    return xbt_dynar_get_as(datanodes, best, struct HdmsgHost *);
+}
+
+/*
+ * Creates the blocks of the input file and places their replicas
+ */
+struct HdfsBlock **placeHdfsBlocks(long number_of_blocks)
+{
+    long i;
+    int r;
+    unsigned int cpt;
+    struct HdmsgHost *datanode;
+    xbt_dynar_t datanodes = get_datanodes();
+    long number_of_datanodes = xbt_dynar_length(datanodes);
+    int replicas = (hdfs_replication < number_of_datanodes) ? hdfs_replication : number_of_datanodes;
+    int random_placement = (strcmp(hdfs_placement, "random") == 0);
+    
+    xbt_assert(number_of_datanodes > 0, "No datanodes to place HDFS blocks on");
+    xbt_assert(random_placement || strcmp(hdfs_placement, "rack_aware") == 0 || strcmp(hdfs_placement, "pinned") == 0,
+               "Unknown HDFS placement policy: %s", hdfs_placement);
+    
+    struct HdfsBlock **blocks = xbt_new(struct HdfsBlock *, number_of_blocks);
+    
+    // Datanodes of equal capacity take plain turns, without the weighted order's scan
+    int equal_capacities = 1;
+    double *capacities = xbt_new(double, number_of_datanodes);
+    double *credits = xbt_new0(double, number_of_datanodes);
+    
+    xbt_dynar_foreach(datanodes, cpt, datanode)
+    {
+        capacities[cpt] = get_capacity(datanode, get_map_slots(datanode));
+        equal_capacities &= (capacities[cpt] == capacities[0]);
+    }
+    
+    for (i = 0; i < number_of_blocks; i++)
+    {
+        struct HdfsBlock *block = arena_alloc(sizeof(struct HdfsBlock));
+        block->block_id = i;
+        block->replicas = arena_alloc(replicas * sizeof(struct HdmsgHost *));
+        
+        for (r = 0; r < replicas; r++)
+        {
+            struct HdmsgHost *replica;
+            
+            if (random_placement)
+            {
+                replica = pick_datanode(datanodes, block, NULL, 0);
+            }
+            else if (r == 0 && equal_capacities)
+            {
+                // The writers take turns over the datanodes
+                replica = xbt_dynar_get_as(datanodes, i % number_of_datanodes, struct HdmsgHost *);
+            }
+            else if (r == 0)
+            {
+                replica = next_writer(datanodes, capacities, credits);
+            }
+            else if (r == 1)
+            {
+                replica = pick_datanode(datanodes, block, block->replicas[0], 0);
+            }
+            else
+            {
+                replica = pick_datanode(datanodes, block, block->replicas[1], 1);
+            }
+            
+            block->replicas[block->replica_count++] = replica;
+        }
+        
+        blocks[i] = block;
+    }
+    
+    free(capacities);
+    free(credits);
+    xbt_dynar_free(&datanodes);
+    
+    return blocks;
+}
+
+// Each worker's fair share of the map tasks and its map capacity, by host_id, while the blocks are scheduled
+static long *map_quotas = NULL;
+static double *map_capacities = NULL;
+
+/*
+ * Keeps the worker in best if it still has room for a map task of the job and is less loaded
+ * for its capacity than best, the lower host_id breaking ties
+ */
+static void consider_worker(struct HdmsgJob *job, struct HdmsgHost *hdmsg_host, struct HdmsgHost **best)
+{
+    long load = xbt_fifo_size(get_job_host(job, hdmsg_host)->map_tasks);
+    
+    if (!hdmsg_host->is_worker || load >= map_quotas[hdmsg_host->host_id])
+    {
+        return;
+    }
+    
+    if (*best != NULL)
+    {
+        double ours = load * map_capacities[(*best)->host_id];
+        double theirs = xbt_fifo_size(get_job_host(job, *best)->map_tasks) * map_capacities[hdmsg_host->host_id];
+        
+        if (ours > theirs || (ours == theirs && hdmsg_host->host_id > (*best)->host_id))
+        {
+            return;
+        }
+    }
+    
+    *best = hdmsg_host;
+}
+
+/*
+ * Returns the least loaded worker that still has room for a map task, among those
+ * holding a replica (HDFS_NODE_LOCAL), sharing a rack with one (HDFS_RACK_LOCAL) or all.
+ * Only the replicas, or the workers of their racks, are looked at.
+ */
+static struct HdmsgHost *least_loaded_worker(struct HdmsgJob *job, struct HdfsBlock *block, int locality)
+{
+    int i;
+    int r;
+    int seen;
+    unsigned int cpt;
+    struct HdmsgHost * hdmsg_host;
+    struct HdmsgHost * best = NULL;
+    
+    if (locality == HDFS_NODE_LOCAL)
+    {
+        for (r = 0; r < block->replica_count; r++)
+        {
+            consider_worker(job, block->replicas[r], &best);
+        }
+    }
+    else if (locality == HDFS_RACK_LOCAL)
+    {
+        for (r = 0; r < block->replica_count; r++)
+        {
+            if (block->replicas[r]->rack == NULL)
+            {
+                continue;
+            }
+            
+            // Each rack once, however many replicas it holds
+            for (seen = 0, i = 0; i < r && !seen; i++)
+            {
+                seen = same_rack(block->replicas[i], block->replicas[r]);
+            }
+            
+            if (!seen)
+            {
+                xbt_dynar_foreach(get_rack(block->replicas[r])->worker_hosts, cpt, hdmsg_host)
+                {
+                    consider_worker(job, hdmsg_host, &best);
+                }
+            }
+        }
+    }
+    else
+    {
+        foreach_hdmsg_host(i, hdmsg_host)
+        {
+            consider_worker(job, hdmsg_host, &best);
+        }
+    }
+    
+    return best;
+}
+
+/*
+ * Assigns each block's map task to a worker, preferring node-local, then rack-local,
+ * then remote workers, without giving any worker more than its share of the job's tasks.
+ */
+void scheduleHdfsBlocks(struct HdmsgJob *job)
+{
+    long i;
+    long number_of_blocks = job->map_tasks;
+    int r;
+    int locality;
+    int h;
+    struct HdmsgHost * hdmsg_host;
+    double total_capacity = 0;
+    int *scheduled = xbt_new0(int, number_of_blocks);
+    
+    map_quotas = xbt_new0(long, host_table_size);
+    map_capacities = xbt_new0(double, host_table_size);
+    
+    foreach_hdmsg_host(h, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            map_capacities[h] = get_capacity(hdmsg_host, get_map_slots(hdmsg_host));
+            total_capacity += map_capacities[h];
+        }
+    }
+    
+    // Each worker's fair share of the map tasks follows how many it can run at once, and how fast
+    foreach_hdmsg_host(h, hdmsg_host)
+    {
+        map_quotas[h] = ceil(number_of_blocks * map_capacities[h] / total_capacity);
+    }
+    
+    // Every block is offered a node-local slot before any block is placed further away
+    for (locality = HDFS_NODE_LOCAL; locality <= HDFS_REMOTE; locality++)
+    {
+        for (i = 0; i < number_of_blocks; i++)
+        {
+            if (scheduled[i])
+            {
+                continue;
+            }
+            
+            struct HdfsBlock *block = job->blocks[i];
+            hdmsg_host = least_loaded_worker(job, block, locality);
+            
+            if (hdmsg_host == NULL)
+            {
+                continue;
+            }
+            
+            block->locality = locality;
+            block->source = NULL;
+            
+            if (locality != HDFS_NODE_LOCAL)
+            {
+                // Read from a replica on the same rack if there is one
+                block->source = block->replicas[0];
+                for (r = 0; r < block->replica_count; r++)
+                {
+                    if (same_rack(block->replicas[r], hdmsg_host))
+                    {
+                        block->source = block->replicas[r];
+                        break;
+                    }
+                }
+            }
+            
+            add_map_task(get_job_host(job, hdmsg_host), block);
+            map_locality[locality]++;
+            scheduled[i] = 1;
+        }
+    }
+    
+    free(scheduled);
+    free(map_quotas);
+    free(map_capacities);
+    map_quotas = NULL;
+    map_capacities = NULL;
+}
+
+/*
+ * Returns the replica a map task running on this host reads its block from, one on the same
+ * rack if possible, or NULL if the host holds a replica. Replicas on crashed hosts are only
+ * read if there is no other. Sets locality to the map's locality.
+ */
+struct HdmsgHost *get_block_source(struct HdfsBlock *block, struct HdmsgHost *this_host, int *locality)
+{
+    int r;
+    struct HdmsgHost *source = block->replicas[0];
+    
+    *locality = HDFS_REMOTE;
+    
+    // A remote map reads the first replica that is up
+    for (r = block->replica_count - 1; r >= 0; r--)
+    {
+        if (!block->replicas[r]->failed)
+        {
+            source = block->replicas[r];
+        }
+    }
+    
+    for (r = 0; r < block->replica_count; r++)
+    {
+        if (block->replicas[r]->failed)
+        {
+            continue;
+        }
+        else if (block->replicas[r] == this_host)
+        {
+            *locality = HDFS_NODE_LOCAL;
+            return NULL;
+        }
+        else if (same_rack(block->replicas[r], this_host) && *locality == HDFS_REMOTE)
+        {
+            *locality = HDFS_RACK_LOCAL;
+            source = block->replicas[r];
+        }
+    }
+    
+    return source;
+}
+
+/** Sets the block's locality and source for a map task running on this host */
+void set_block_reader(struct HdfsBlock *block, struct HdmsgHost *this_host)
+{
+    block->source = get_block_source(block, this_host, &block->locality);
+}
+
+/*
+ * Returns the worker with the most queued map tasks of the job, or NULL if none has any
+ */
+static struct HdmsgJobHost *most_loaded_worker(struct HdmsgJob *job)
+{
+    int i;
+    struct HdmsgHost * hdmsg_host;
+    struct HdmsgJobHost * most_loaded = NULL;
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        struct HdmsgJobHost *job_host = get_job_host(job, hdmsg_host);
+        
+        if (hdmsg_host->is_worker && xbt_fifo_size(job_host->map_tasks) > 0 &&
+            (most_loaded == NULL || xbt_fifo_size(job_host->map_tasks) > xbt_fifo_size(most_loaded->map_tasks)))
+        {
+            most_loaded = job_host;
+        }
+    }
+    
+    return most_loaded;
+}
+
+/*
+ * Moves a queued map task of the job from the most loaded worker to this host. The first time
+ * a mapper asks, it waits locality_delay seconds for its own host's work first. Returns 0 if
+ * there is nothing left to steal.
+ */
+int steal_map_task(struct HdmsgJobHost *this_host, int *waited)
+{
+    if (most_loaded_worker(this_host->job) == NULL)
+    {
+        return 0;
+    }
+    
+    if (!*waited && locality_delay > 0)
+    {
+        *waited = 1;
+        MSG_process_sleep(locality_delay);
+        simulation_events++;
+        
+        if (xbt_fifo_size(this_host->map_tasks) > 0)
+        {
+            return 1;
+        }
+    }
+    
+    struct HdmsgJobHost *victim = most_loaded_worker(this_host->job);
+    if (victim == NULL)
+    {
+        return 0;
+    }
+    
+    // Take the task the victim would run last
+    struct HdfsBlock *block = xbt_fifo_shift(victim->map_tasks);
+    
+    // Its block now has to come to this host
+    map_locality[block->locality]--;
+    set_block_reader(block, this_host->host);
+    map_locality[block->locality]++;
+    stolen_maps++;
+    
+    xbt_fifo_push(this_host->map_tasks, block);
+    
+    return 1;
+}
+
+/*
+ * Copies a block from its source replica to the calling mapper over the network, from
+ * another replica if the source is down
+ */
+void readRemoteBlock(struct HdmsgJob *job, struct HdfsBlock *block)
+{
+    struct HdmsgHost *this_host = get_hdmsg_host(MSG_host_self());
+    
+    while (block->source != NULL && receiveFromHost(block->source, job->hdfs_chunk_size_bytes) != MSG_OK)
+    {
+        retryBlockRead(job, block, this_host);
+    }
+}
+
+/*
+ * Copies bytes from a host to the calling process over the network. A short-lived
+ * DataNode process on the source host sends them. Returns MSG_OK unless the source
+ * crashed or a link failure cut the transfer off.
+ */
+msg_error_t receiveFromHost(struct HdmsgHost *source, double bytes)
+{
+    msg_task_t task = NULL;
+    struct HdmsgHost *this_host = get_hdmsg_host(MSG_host_self());
+    
+    // A crashed host refuses the connection
+    if (source->failed)
+    {
+        return MSG_HOST_FAILURE;
+    }
+    
+    // The transfer carries its destination, so the DataNode can account for the bytes
+    msg_task_t transfer = MSG_task_create("hdfs_block", 0, bytes, this_host);
+    char mailbox[INTERNED_NAME_SIZE];
+    snprintf(mailbox, sizeof(mailbox), "%s-Transfer-%ld", MSG_process_get_name(MSG_process_self()), next_transfer++);
+    MSG_task_set_name(transfer, mailbox);
+    
+    watch_transfer(source, transfer);
+    MSG_process_create(intern_name("%s-DataNode", source->host_name), hdfsServeBlock, transfer, source->host);
+    
+    msg_error_t res = MSG_task_receive(&task, mailbox);
+    simulation_events++;
+    
+    // The source crashed before its DataNode started sending
+    if (res == MSG_OK && strcmp(MSG_task_get_name(task), "host_failed") == 0)
+    {
+        res = MSG_HOST_FAILURE;
+    }
+    
+    if (task != NULL)
+    {
+        MSG_task_destroy(task);
+    }
+    
+    return res;
+}
+
+/** DataNode Process: reads one transfer from its disk and sends it, named after the mailbox it goes to */
+int hdfsServeBlock(int argc, char * argv[])
+{
+    msg_task_t transfer = MSG_process_get_data(MSG_process_self());
+    struct HdmsgHost *this_host = get_hdmsg_host(MSG_host_self());
+    
+    struct HdmsgHost *destination = MSG_task_get_data(transfer);
+    double bytes = MSG_task_get_bytes_amount(transfer);
+    
+    disk_read(this_host, bytes);
+    unwatch_transfer(this_host, transfer);
+    
+    double start_time = MSG_get_clock();
+    
+    // The reader tries again after a link failure, with a transfer of its own
+    if (MSG_task_send(transfer, MSG_task_get_name(transfer)) != MSG_OK)
+    {
+        MSG_task_destroy(transfer);
+        simulation_events++;
+        return 0;
+    }
+    
+    simulation_events++;
+    METRICS_LINK(this_host, destination, start_time, bytes);
+    
+    return 0;
+}
+
+/*
+ * Returns the number of map tasks on a host that read their block from another host
+ */
+long get_remote_map_count(struct HdmsgJobHost *this_host)
+{
+    long count = 0;
+    struct HdfsBlock *block;
+    xbt_fifo_item_t bucket;
+    
+    xbt_fifo_foreach(this_host->map_tasks, bucket, block, struct HdfsBlock *)
+    {
+        count += (block->source != NULL) ? 1 : 0;
+    }
+    
+    return count;
+}
@@ -0,0 +1,73 @@
+//
+//  HdmsgHdfs.h
+//  HDMSG
+//
+
+#ifndef HDMSGHDFS_H
+#define HDMSGHDFS_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+#define HDFS_NODE_LOCAL 0
+#define HDFS_RACK_LOCAL 1
+#define HDFS_REMOTE     2
+
+extern int hdfs_replication;
+extern char *hdfs_placement;
+extern char *hdfs_pinned_hosts;
+
+// Map tasks scheduled at each locality level, indexed by HDFS_NODE_LOCAL .. HDFS_REMOTE
+extern long map_locality[3];
+
+extern int work_stealing;
+extern double locality_delay;
+extern long stolen_maps;
+
+// Defined in HDMSG.c
+extern long simulation_events;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+struct HdfsBlock
+{
+    long block_id;
+    
+    int replica_count;
+    struct HdmsgHost **replicas;    // Hosts holding a copy, the writer's first
+    
+    struct HdmsgHost *source;       // Replica a non-local map reads from, NULL when node-local
+    int locality;
+    
+    struct HdmsgHost *map_host;     // Host running its map, then holding its output
+    int mapped;                     // Set once a map of the block has completed
+    int attempts;                   // Failed map attempts
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+struct HdfsBlock **placeHdfsBlocks(long);
+void scheduleHdfsBlocks(struct HdmsgJob *);
+int holds_replica(struct HdfsBlock *, struct HdmsgHost *);
+struct HdmsgHost *get_block_source(struct HdfsBlock *, struct HdmsgHost *, int *);
+void set_block_reader(struct HdfsBlock *, struct HdmsgHost *);
+void readRemoteBlock(struct HdmsgJob *, struct HdfsBlock *);
+msg_error_t receiveFromHost(struct HdmsgHost *, double);
+int steal_map_task(struct HdmsgJobHost *, int *);
+long get_remote_map_count(struct HdmsgJobHost *);
+
+int hdfsServeBlock(int argc, char * argv[]);
+
+// Defined in HDMSG.c
+double get_map_cost(msg_host_t, struct HdmsgJob *);
+
+#endif /* HdmsgHdfs_h */
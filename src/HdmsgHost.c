@@ -7,83 +7,335 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "HdmsgHost.h"
+#include "HdmsgPool.h"
+#include "HdmsgHdfs.h"
+#include "HdmsgSkew.h"
 
-struct HdmsgHost *newHdmsgHost(int host_id, msg_host_t msg_host, char * attributes)
+// Defined in HDMSG.c
+extern int BYTES_PER_MEGABYTE;
+
+struct HdmsgHost **host_table = NULL;
+int host_table_size = 0;
+
+struct HdmsgHost *newHdmsgHost(int host_id, msg_host_t msg_host, int roles)
 {
-    struct HdmsgHost *this_host = malloc(sizeof(struct HdmsgHost));
+    struct HdmsgHost *this_host = arena_alloc(sizeof(struct HdmsgHost));
     
     this_host->host_id = host_id;
     this_host->host = msg_host;
     this_host->host_name = MSG_host_get_name(msg_host);
+    this_host->rack = NULL;
+    this_host->rack_id = -1;
     
-    this_host->is_master = (strstr(attributes, "master") == NULL) ? 0 : 1;
-    this_host->is_worker = (strstr(attributes, "worker") == NULL) ? 0 : 1;
+    this_host->is_master = (roles & HOST_MASTER) ? 1 : 0;
+    this_host->is_worker = (roles & HOST_WORKER) ? 1 : 0;
     
     // Processes
-    this_host->active_mappers = 0;
-    this_host->mappers = xbt_fifo_new();
-    this_host->reducers = xbt_fifo_new();
-    this_host->shuffle_senders = xbt_fifo_new();
+    this_host->busy_time = 0;
+    
+    this_host->failed = 0;
+    this_host->lost = 0;
+    this_host->blacklisted = 0;
+    this_host->failed_attempts = 0;
+    this_host->pending_transfers = NULL;
+    
+    this_host->slowdown = 1;
+    this_host->running_tasks = 0;
+    this_host->finished_attempts = 0;
+    this_host->finished_attempt_time = 0;
     
-    // Work queues
-    this_host->map_tasks = xbt_fifo_new();
-    this_host->shuffle_tasks = xbt_fifo_new();
-    this_host->reduce_tasks = xbt_fifo_new();
+    this_host->memory_mb = 0;
+    this_host->vcores = 0;
+    this_host->free_memory_mb = 0;
+    this_host->free_vcores = 0;
+    this_host->container_requests = xbt_fifo_new();
+    
+    this_host->disk = NULL;
+    this_host->disk_bandwidth = 0;
+    this_host->disk_busy_time = 0;
     
     return this_host;
 }
 
-int get_mapper_count(struct HdmsgHost *this_host)
+/*
+ * Creates a job over input_size MB in hdfs_chunk_size MB blocks, with its part of every
+ * registered host. A job without a name is the single job of the simulation.
+ */
+struct HdmsgJob *newHdmsgJob(int job_id, const char *name, long input_size, long hdfs_chunk_size, long reducers)
+{
+    int i;
+    struct HdmsgJob *job = arena_alloc(sizeof(struct HdmsgJob));
+    
+    job->job_id = job_id;
+    job->name = name;
+    job->prefix = (name != NULL) ? intern_name("%s-", name) : "";
+    job->mailbox = (name != NULL) ? intern_name("%smaster", job->prefix) : "master";
+    
+    job->input_size = input_size;
+    job->input_size_bytes = input_size * BYTES_PER_MEGABYTE;
+    job->hdfs_chunk_size = hdfs_chunk_size;
+    job->hdfs_chunk_size_bytes = hdfs_chunk_size * BYTES_PER_MEGABYTE;
+    job->reducers = reducers;
+    job->map_tasks = job->input_size_bytes / job->hdfs_chunk_size_bytes;
+    
+    job->reducer_shares = computeReducerShares(reducers);
+    job->reducer_quotas = NULL;
+    job->blocks = NULL;
+    job->hosts = arena_alloc(host_table_size * sizeof(struct HdmsgJobHost));
+    
+    for (i = 0; i < host_table_size; i++)
+    {
+        struct HdmsgJobHost *job_host = &job->hosts[i];
+        
+        job_host->job = job;
+        job_host->host = host_table[i];
+        job_host->active_mappers = 0;
+        job_host->reported_mappers = 0;
+        job_host->reported_shufflers = 0;
+        job_host->reported_reducers = 0;
+        
+        // Work queues
+        job_host->map_tasks = xbt_fifo_new();
+        job_host->posted_shuffles = 0;
+        job_host->taken_shuffles = 0;
+        
+        job_host->mappers = xbt_fifo_new();
+        job_host->reducers = xbt_fifo_new();
+        job_host->shuffle_senders = xbt_fifo_new();
+        job_host->shuffle_work = NULL;
+    }
+    
+    job->reducer_table = NULL;
+    job->reducer_table_size = 0;
+    job->map_outputs = NULL;
+    job->next_partition = 0;
+    
+    job->mappers_launched = 0;
+    job->reducers_launched = 0;
+    job->shuffle_started = 0;
+    job->reduce_started = 0;
+    job->completed_maps = 0;
+    
+    job->sim_map = 0;
+    job->sim_reduce = 0;
+    job->running_tasks = 0;
+    
+    job->queue = NULL;
+    job->arrival_time = 0;
+    job->start_time = -1;
+    job->finish_time = -1;
+    
+    return job;
+}
+
+struct HdmsgReducer *newHdmsgReducer(struct HdmsgJob *job, int reducer_id, long partition, struct HdmsgHost *this_host, long expected_segments)
+{
+    struct HdmsgReducer *reducer = arena_alloc(sizeof(struct HdmsgReducer));
+    
+    reducer->reducer_id = reducer_id;
+    reducer->partition = partition;
+    reducer->job = job;
+    reducer->host = this_host;
+    reducer->mailbox = intern_name("%s%s-Reducer-%d", job->prefix, this_host->host_name, reducer_id);
+    
+    reducer->expected_segments = expected_segments;
+    reducer->received_segments = 0;
+    reducer->received_bytes = 0;
+    reducer->buffered_bytes = 0;
+    reducer->disk_bytes = 0;
+    reducer->disk_segments = 0;
+    reducer->finish_time = 0;
+    
+    reducer->process = NULL;
+    reducer->receivers = xbt_fifo_new();
+    
+    reducer->fetched_outputs = 0;
+    reducer->fetched_blocks = NULL;
+    reducer->attempts = 0;
+    reducer->fetch_work = MSG_sem_init(0);
+    
+    reducer->merge_work = MSG_sem_init(0);
+    
+    return reducer;
+}
+
+/*
+ * Puts a host with its final host_id in host_table, and attaches it to its msg_host_t
+ */
+void registerHdmsgHost(struct HdmsgHost *this_host)
+{
+    if (this_host->host_id >= host_table_size)
+    {
+        int size = this_host->host_id + 1;
+        host_table = realloc(host_table, size * sizeof(struct HdmsgHost *));
+        memset(host_table + host_table_size, 0, (size - host_table_size) * sizeof(struct HdmsgHost *));
+        host_table_size = size;
+    }
+    
+    host_table[this_host->host_id] = this_host;
+    MSG_host_set_data(this_host->host, this_host);
+}
+
+/*
+ * Lists every reducer of a job once all hosts have created theirs, so each map output is
+ * partitioned without walking the hosts. Pulling reducers share one list of the map outputs.
+ */
+void buildReducerTable(struct HdmsgJob *job)
+{
+    int i;
+    long next = 0;
+    xbt_fifo_item_t bucket;
+    struct HdmsgReducer *reducer = NULL;
+    
+    job->reducer_table_size = 0;
+    for (i = 0; i < host_table_size; i++)
+    {
+        job->reducer_table_size += get_reducer_count(&job->hosts[i]);
+    }
+    
+    job->reducer_table = arena_alloc(job->reducer_table_size * sizeof(struct HdmsgReducer *));
+    job->map_outputs = xbt_dynar_new(sizeof(struct MapOutput), NULL);
+    
+    for (i = 0; i < host_table_size; i++)
+    {
+        xbt_fifo_foreach(job->hosts[i].reducers, bucket, reducer, struct HdmsgReducer *)
+        {
+            job->reducer_table[next++] = reducer;
+        }
+    }
+}
+
+/*
+ * Returns the host state of a platform host, or NULL if the config does not use it
+ */
+struct HdmsgHost *get_hdmsg_host(msg_host_t msg_host)
+{
+    return MSG_host_get_data(msg_host);
+}
+
+/*
+ * Returns a job's part of a host
+ */
+struct HdmsgJobHost *get_job_host(struct HdmsgJob *job, struct HdmsgHost *this_host)
+{
+    return &job->hosts[this_host->host_id];
+}
+
+int get_mapper_count(struct HdmsgJobHost *this_host)
 {
     return xbt_fifo_size(this_host->mappers);
 }
 
-int get_shuffler_count(struct HdmsgHost *this_host)
+int get_shuffler_count(struct HdmsgJobHost *this_host)
 {
-    return xbt_fifo_size(this_host->shuffle_senders);
+    int fetchers = 0;
+    xbt_fifo_item_t bucket;
+    struct HdmsgReducer *reducer = NULL;
+    
+    // Fetchers report to the master like senders do
+    if (pull_shuffle)
+    {
+        xbt_fifo_foreach(this_host->reducers, bucket, reducer, struct HdmsgReducer *)
+        {
+            fetchers += xbt_fifo_size(reducer->receivers);
+        }
+    }
+    
+    return xbt_fifo_size(this_host->shuffle_senders) + fetchers;
 }
 
-int get_reducer_count(struct HdmsgHost *this_host)
+int get_reducer_count(struct HdmsgJobHost *this_host)
 {
     return xbt_fifo_size(this_host->reducers);
 }
 
-void add_map_task(struct HdmsgHost *this_host, double compute_cost)
+void add_map_task(struct HdmsgJobHost *this_host, void *block)
 {
-    msg_task_t map_task = MSG_task_create("map", compute_cost, 0, NULL);
-    xbt_fifo_push(this_host->map_tasks, map_task);
+    xbt_fifo_push(this_host->map_tasks, block);
     return;
 }
 
-void partition_map_task(struct HdmsgHost *this_host, double communication_cost)
+void partition_map_task(struct HdmsgJobHost *this_host, struct HdfsBlock *block)
 {
-    int i;
-    char * key;
-    struct HdmsgHost * other_host;
-    xbt_dict_cursor_t cursor = NULL;
+    long i;
+    struct HdmsgJob *job = this_host->job;
+    struct MapOutput output = { this_host->host, block };
+    
+    block->map_host = this_host->host;
+    block->mapped = 1;
+    
+    // A pulled shuffle only tells the reducers' fetchers where the output is
+    if (pull_shuffle)
+    {
+        xbt_dynar_push(job->map_outputs, &output);
+    }
+    else
+    {
+        this_host->posted_shuffles += job->reducer_table_size;
+    }
     
-    // Create a shuffle task for each reducer and store in the shuffle_tasks work queue
-    xbt_dict_foreach(hosts, cursor, key, other_host)
+    // Wake one sender or fetcher for each reducer's segment
+    for (i = 0; i < job->reducer_table_size; i++)
     {
-        if (other_host->is_worker)
+        MSG_sem_release(pull_shuffle ? job->reducer_table[i]->fetch_work : this_host->shuffle_work);
+    }
+    
+    return;
+}
+
+/*
+ * Returns the reducer of the next shuffle task posted on this host, or NULL if every
+ * posted task has been taken
+ */
+struct HdmsgReducer *take_shuffle_task(struct HdmsgJobHost *this_host)
+{
+    struct HdmsgJob *job = this_host->job;
+    
+    if (this_host->taken_shuffles == this_host->posted_shuffles)
+    {
+        return NULL;
+    }
+    
+    return job->reducer_table[this_host->taken_shuffles++ % job->reducer_table_size];
+}
+
+/*
+ * Takes the next map output a reducer has not fetched. Returns 0 if it has taken them all.
+ * When hosts can fail, outputs on lost hosts and second outputs of a block are passed over.
+ */
+int take_map_output(struct HdmsgReducer *reducer, struct MapOutput *output)
+{
+    xbt_dynar_t map_outputs = reducer->job->map_outputs;
+    
+    while (reducer->fetched_outputs < xbt_dynar_length(map_outputs))
+    {
+        *output = xbt_dynar_get_as(map_outputs, reducer->fetched_outputs++, struct MapOutput);
+        
+        if (reducer->fetched_blocks == NULL)
         {
-            for (i = 0; i < xbt_fifo_size(other_host->reducers); i++)
-            {
-                msg_task_t shuffle_task = MSG_task_create("shuffle", 0, communication_cost, other_host->host);
-                xbt_fifo_push(this_host->shuffle_tasks, shuffle_task);
-            }
+            return 1;
+        }
+        
+        if (!output->host->lost && reducer->fetched_blocks[output->block->block_id] == FETCH_NONE)
+        {
+            reducer->fetched_blocks[output->block->block_id] = FETCH_RUNNING;
+            return 1;
         }
     }
     
-    return;
+    return 0;
 }
 
-void activate_mappers(struct HdmsgHost *this_host)
+void activate_mappers(struct HdmsgJobHost *this_host)
 {
     xbt_fifo_item_t bucket;
     msg_process_t mapper = NULL;
     
+    this_host->job->mappers_launched = 1;
+    
     xbt_fifo_foreach(this_host->mappers, bucket, mapper, msg_process_t)
     {
         MSG_process_resume(mapper);
@@ -92,14 +344,33 @@ void activate_mappers(struct HdmsgHost *this_host)
     return;
 }
 
-void activate_reducers(struct HdmsgHost *this_host)
+void activate_reducers(struct HdmsgJobHost *this_host)
 {
     xbt_fifo_item_t bucket;
-    msg_process_t reducer = NULL;
+    xbt_fifo_item_t receiver_bucket;
+    struct HdmsgReducer *reducer = NULL;
+    msg_process_t receiver = NULL;
+    
+    this_host->job->reducers_launched = 1;
+    
+    // The processes of a crashed host are gone
+    if (this_host->host->failed)
+    {
+        return;
+    }
     
-    xbt_fifo_foreach(this_host->reducers, bucket, reducer, msg_process_t)
+    xbt_fifo_foreach(this_host->reducers, bucket, reducer, struct HdmsgReducer *)
     {
-        MSG_process_resume(reducer);
+        MSG_process_resume(reducer->process);
+        
+        // Pipelined receivers and fetchers only start copying once their reducer has been launched
+        if (pipelined_reduce || pull_shuffle)
+        {
+            xbt_fifo_foreach(reducer->receivers, receiver_bucket, receiver, msg_process_t)
+            {
+                MSG_process_resume(receiver);
+            }
+        }
     }
     
     return;
@@ -17,54 +17,209 @@
 //////////////////////
 extern int SHUFFLERS_PER_REDUCER;
 
+extern int pipelined_reduce;
+extern int pull_shuffle;
+
 extern int mappers_per_worker;
 extern int reducers_per_worker;
 extern int number_of_workers;
 
 extern xbt_dict_t hosts;
 
+// Roles the config gives a host, or'ed together
+#define HOST_MASTER 1
+#define HOST_WORKER 2
+
+// What a reducer has of each block's map output, when hosts can fail
+#define FETCH_NONE    0
+#define FETCH_RUNNING 1
+#define FETCH_DONE    2
+
+// Dense registries, so hot paths index arrays instead of hashing host names
+extern struct HdmsgHost **host_table;           // Indexed by host_id
+extern int host_table_size;
+
+// Visits every host of the config in host_id order
+#define foreach_hdmsg_host(i, hdmsg_host) \
+    for ((i) = 0; (i) < host_table_size && ((hdmsg_host) = host_table[(i)], 1); (i)++)
+
 //////////////////////
 // Types
 //////////////////////
 
+struct HdfsBlock;
+
 struct HdmsgHost
 {
     int host_id;
     int is_master;
     int is_worker;
     
-    int active_mappers;
+    double busy_time;       // Sum of the durations of the tasks run here, in core-seconds
+    
+    int failed;             // Crashed, with its processes and map outputs
+    int lost;               // The master has noticed the crash and rescheduled its work
+    int blacklisted;        // Takes no more map tasks after too many failed attempts
+    int failed_attempts;
+    
+    xbt_fifo_t pending_transfers;   // msg_task_t a DataNode here has to send, when hosts can fail
+    
+    double slowdown;        // straggler_factor on straggler hosts, otherwise 1
+    int running_tasks;      // Map and reduce attempts running, when speculation tracks them
+    long finished_attempts;
+    double finished_attempt_time;
+    
+    long memory_mb;         // NodeManager resources, when containers are modeled
+    int vcores;
+    long free_memory_mb;
+    int free_vcores;
+    xbt_fifo_t container_requests;  // struct ContainerRequest *, granted in order
     
-    xbt_fifo_t map_tasks;
-    xbt_fifo_t reduce_tasks;
-    xbt_fifo_t shuffle_tasks;
+    msg_sem_t disk;         // Held while the local disk serves a read or write
+    double disk_bandwidth;  // Of the local disk, in bytes per second
+    double disk_busy_time;
     
     const char *host_name;
+    const char *rack;       // Innermost AS of the platform containing the host
+    int rack_id;            // Index in racks
     
     msg_host_t host;
+};
+
+
+// A job's part of a host: its queued map tasks, and its processes there
+struct HdmsgJobHost
+{
+    struct HdmsgJob *job;
+    struct HdmsgHost *host;
+    
+    int active_mappers;
+    
+    // Processes whose exit message reached the master. The master reports for the rest if the host is lost.
+    long reported_mappers;
+    long reported_shufflers;
+    long reported_reducers;
+    
+    // Work queues hold descriptors, and tasks are only created when the work starts
+    xbt_fifo_t map_tasks;       // struct HdfsBlock * of each map task not started yet
+    long posted_shuffles;       // The k-th shuffle task posted here goes to reducer_table[k % reducer_table_size]
+    long taken_shuffles;
     
-    xbt_fifo_t mappers;     // = mappers_per_worker
-    xbt_fifo_t reducers;    // = reducers_per_worker
+    xbt_fifo_t mappers;     // = map slots of the host
+    xbt_fifo_t reducers;    // struct HdmsgReducer *, the host's share of the job's reducers
     
     xbt_fifo_t shuffle_senders;
+    msg_sem_t shuffle_work;     // Released once per shuffle task, then once per sender when the mappers are done
+};
+
+
+// One MapReduce job, run by its own master. The single-job simulation has one, a workload
+// one per job of its trace.
+struct HdmsgJob
+{
+    int job_id;                     // Line of the job in the workload trace, 0 for the single job
+    const char *name;               // NULL for the single job
+    const char *prefix;             // Put before its process and mailbox names, "" for the single job
+    const char *mailbox;            // Of its master
+    
+    long input_size;                // In MB
+    long input_size_bytes;
+    long hdfs_chunk_size;           // In MB
+    long hdfs_chunk_size_bytes;
+    long reducers;
+    long map_tasks;
+    
+    double *reducer_shares;         // Share of the map output each partition receives
+    long *reducer_quotas;           // Reducers each worker runs, by host_id
+    
+    struct HdfsBlock **blocks;      // Every block of the input, by block_id
+    struct HdmsgJobHost *hosts;     // By host_id
+    
+    struct HdmsgReducer **reducer_table;    // Every reducer, in host_id order
+    long reducer_table_size;
+    xbt_dynar_t map_outputs;                // struct MapOutput of each completed map, in completion order
+    long next_partition;
     
+    // Set once the master has launched the mappers or reducers. Tasks relaunched after that start right away.
+    int mappers_launched;
+    int reducers_launched;
+    int shuffle_started;
+    int reduce_started;
+    long completed_maps;
+    
+    double sim_map;                 // Sums of the map and reduce task durations
+    double sim_reduce;
+    int running_tasks;              // Tasks holding a container
+    
+    // Set in workload mode
+    struct WorkloadQueue *queue;
+    double arrival_time;
+    double start_time;              // When its first map started, -1 until then
+    double finish_time;
+};
+
+
+struct HdmsgReducer
+{
+    int reducer_id;             // Index on its host
+    long partition;             // Index across the job, selects the reducer's share of the keys
+    struct HdmsgJob *job;
+    struct HdmsgHost *host;
+    
+    char *mailbox;              // Stable mailbox all shuffle segments for this reducer are sent to
+    long expected_segments;     // One segment per map task
+    long received_segments;
+    double received_bytes;
+    double buffered_bytes;      // Shuffled bytes held in memory, when disks are modeled
+    double disk_bytes;          // and written to disk, in disk_segments segments
+    long disk_segments;
+    double finish_time;
+    
+    msg_process_t process;
+    xbt_fifo_t receivers;       // Fixed pool of shuffle receivers reading the mailbox, or fetchers
+    
+    long fetched_outputs;       // Map outputs taken by the fetchers, an index in map_outputs
+    char *fetched_blocks;       // FETCH_NONE .. FETCH_DONE by block, when hosts can fail
+    int attempts;               // Failed reduce attempts
+    msg_sem_t fetch_work;       // Released once per completed map when the shuffle is pulled
+    
+    msg_sem_t merge_work;       // Released once per received segment when reduce is pipelined or pulled
+};
+
+
+// A completed map's output, and the host a pulling reducer fetches it from
+struct MapOutput
+{
+    struct HdmsgHost *host;
+    struct HdfsBlock *block;
 };
 
 
 //////////////////////
 // Prototypes
 //////////////////////
-struct HdmsgHost *newHdmsgHost(int, msg_host_t, char *);
+struct HdmsgHost *newHdmsgHost(int, msg_host_t, int);
+struct HdmsgJob *newHdmsgJob(int, const char *, long, long, long);
+struct HdmsgReducer *newHdmsgReducer(struct HdmsgJob *, int, long, struct HdmsgHost *, long);
+void registerHdmsgHost(struct HdmsgHost *);
+void buildReducerTable(struct HdmsgJob *);
+struct HdmsgHost *get_hdmsg_host(msg_host_t);
+struct HdmsgJobHost *get_job_host(struct HdmsgJob *, struct HdmsgHost *);
 
-int get_mapper_count(struct HdmsgHost *);
-int get_shuffler_count(struct HdmsgHost *);
-int get_reducer_count(struct HdmsgHost *);
+int get_mapper_count(struct HdmsgJobHost *);
+int get_shuffler_count(struct HdmsgJobHost *);
+int get_reducer_count(struct HdmsgJobHost *);
 
-void add_map_task(struct HdmsgHost *, double);
-void partition_map_task(struct HdmsgHost *, double);
-void activate_mappers(struct HdmsgHost*);
-void activate_reducers(struct HdmsgHost *);
+void add_map_task(struct HdmsgJobHost *, void *);
+void partition_map_task(struct HdmsgJobHost *, struct HdfsBlock *);
+struct HdmsgReducer *take_shuffle_task(struct HdmsgJobHost *);
+int take_map_output(struct HdmsgReducer *, struct MapOutput *);
+void activate_mappers(struct HdmsgJobHost *);
+void activate_reducers(struct HdmsgJobHost *);
 
 void destroyHdmsgHost(struct HdmsgHost *);
 
+// Defined in HDMSG.c
+double get_bytes_to_shuffle(struct HdmsgJob *, long);
+
 #endif /* HdmsgHost_h */
@@ -0,0 +1,337 @@
+//
+//  HdmsgMetrics.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HdmsgMetrics.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// JSON report of the task latency histograms and the per-host utilization time series.
+// NULL to disable metrics.
+char *metrics_file = NULL;
+double metrics_interval = 10;       // Seconds per utilization sample
+int recording_metrics = 0;
+
+static const char *task_names[METRICS_TASK_TYPES] = { "map", "shuffle", "reduce" };
+
+static struct Histogram *histograms;
+static struct HostSeries *series;   // Indexed by host_id
+static int series_count;
+
+/*
+ * Returns the bucket of a value in microseconds. Values below 2^HISTOGRAM_SUB_BITS have a
+ * bucket each. Above that, each power of two is split into 2^(HISTOGRAM_SUB_BITS - 1) buckets.
+ */
+static long get_bucket_index(long long value)
+{
+    int magnitude = 0;
+    long long high_bits = value >> HISTOGRAM_SUB_BITS;
+    
+    while (high_bits > 0)
+    {
+        magnitude++;
+        high_bits >>= 1;
+    }
+    
+    return ((long) magnitude << (HISTOGRAM_SUB_BITS - 1)) + (long) (value >> magnitude);
+}
+
+/*
+ * Returns the highest value in microseconds that falls in a bucket
+ */
+static long long get_bucket_value(long index)
+{
+    int magnitude = (index < (1 << HISTOGRAM_SUB_BITS)) ? 0 : (int) (index >> (HISTOGRAM_SUB_BITS - 1)) - 1;
+    long long sub_bucket = index - ((long) magnitude << (HISTOGRAM_SUB_BITS - 1));
+    
+    return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+void histogram_record(struct Histogram *histogram, double seconds)
+{
+    long long value = (long long) (seconds * 1e6);
+    long long limit = (1LL << HISTOGRAM_MAX_BITS) - 1;
+    
+    value = (value < 0) ? 0 : (value > limit) ? limit : value;
+    histogram->counts[get_bucket_index(value)]++;
+    
+    histogram->min = (histogram->total == 0) ? seconds : fmin(histogram->min, seconds);
+    histogram->max = (histogram->total == 0) ? seconds : fmax(histogram->max, seconds);
+    histogram->sum += seconds;
+    histogram->total++;
+}
+
+/*
+ * Returns the nearest-rank percentile p (0 to 1) of a histogram, in seconds
+ */
+double histogram_percentile(struct Histogram *histogram, double p)
+{
+    long i;
+    long seen = 0;
+    long rank = (long) ceil(p * histogram->total);
+    rank = (rank < 1) ? 1 : rank;
+    
+    if (histogram->total == 0)
+    {
+        return 0;
+    }
+    
+    for (i = 0; i < HISTOGRAM_SIZE; i++)
+    {
+        seen += histogram->counts[i];
+        
+        if (seen >= rank)
+        {
+            return fmin(get_bucket_value(i) / 1e6, histogram->max);
+        }
+    }
+    
+    return histogram->max;
+}
+
+static void grow_series(struct TimeSeries *time_series, long length)
+{
+    if (length <= time_series->length)
+    {
+        return;
+    }
+    
+    if (length > time_series->capacity)
+    {
+        long capacity = (time_series->capacity > 0) ? time_series->capacity : 64;
+        
+        while (capacity < length)
+        {
+            capacity *= 2;
+        }
+        
+        time_series->values = realloc(time_series->values, capacity * sizeof(double));
+        time_series->capacity = capacity;
+    }
+    
+    memset(time_series->values + time_series->length, 0, (length - time_series->length) * sizeof(double));
+    time_series->length = length;
+}
+
+/*
+ * Adds an amount spent evenly from start_time to end_time to the intervals it overlaps
+ */
+static void spread(struct TimeSeries *time_series, double start_time, double end_time, double amount)
+{
+    long i;
+    long first = (long) (start_time / metrics_interval);
+    long last = (long) (end_time / metrics_interval);
+    
+    grow_series(time_series, last + 1);
+    
+    if (end_time <= start_time)
+    {
+        time_series->values[last] += amount;
+        return;
+    }
+    
+    for (i = first; i <= last; i++)
+    {
+        double overlap = fmin(end_time, (i + 1) * metrics_interval) - fmax(start_time, i * metrics_interval);
+        time_series->values[i] += amount * overlap / (end_time - start_time);
+    }
+}
+
+static void free_series(struct TimeSeries *time_series)
+{
+    free(time_series->values);
+}
+
+/*
+ * Starts recording metrics if metrics_file is set
+ */
+void openMetrics()
+{
+    int i;
+    struct HdmsgHost * hdmsg_host;
+    
+    if (metrics_file == NULL)
+    {
+        return;
+    }
+    
+    histograms = xbt_new0(struct Histogram, METRICS_TASK_TYPES);
+    
+    series_count = host_table_size;
+    series = xbt_new0(struct HostSeries, series_count);
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        series[i].host = hdmsg_host;
+    }
+    
+    recording_metrics = 1;
+}
+
+/*
+ * Records the duration of a task that started at start_time and just finished
+ */
+void metricsTask(int type, double start_time)
+{
+    histogram_record(&histograms[type], MSG_get_clock() - start_time);
+}
+
+/*
+ * Records one core of a host held from start_time to now
+ */
+void metricsBusy(struct HdmsgHost *this_host, double start_time)
+{
+    spread(&series[this_host->host_id].busy_seconds, start_time, MSG_get_clock(), MSG_get_clock() - start_time);
+}
+
+/*
+ * Records bytes that went from one host to another between start_time and now
+ */
+void metricsLink(struct HdmsgHost *source, struct HdmsgHost *destination, double start_time, double bytes)
+{
+    if (source == destination)
+    {
+        return;
+    }
+    
+    spread(&series[source->host_id].bytes_out, start_time, MSG_get_clock(), bytes);
+    spread(&series[destination->host_id].bytes_in, start_time, MSG_get_clock(), bytes);
+}
+
+/*
+ * Writes one host's series as fractions of its capacity in each interval
+ */
+static void write_utilization(FILE *metrics_output, const char *name, struct TimeSeries *time_series,
+                              double capacity, long intervals, double simulation_time)
+{
+    long i;
+    
+    fprintf(metrics_output, ",\"%s\":[", name);
+    
+    for (i = 0; i < intervals; i++)
+    {
+        double width = fmin(metrics_interval, simulation_time - i * metrics_interval);
+        double value = (i < time_series->length) ? time_series->values[i] : 0;
+        fprintf(metrics_output, "%s%.4f", (i == 0) ? "" : ",", value / (capacity * width));
+    }
+    
+    fputs("]", metrics_output);
+}
+
+static double get_peak(struct TimeSeries *time_series, double capacity, double simulation_time)
+{
+    long i;
+    double peak = 0;
+    
+    for (i = 0; i < time_series->length; i++)
+    {
+        double width = fmin(metrics_interval, simulation_time - i * metrics_interval);
+        peak = (width > 0) ? fmax(peak, time_series->values[i] / (capacity * width)) : peak;
+    }
+    
+    return peak;
+}
+
+/*
+ * Writes the report to metrics_file, logs a summary and stops recording
+ */
+void closeMetrics()
+{
+    int i;
+    int first_host = 1;
+    double simulation_time = MSG_get_clock();
+    double link_capacity = analytic_bandwidth * 1e6;
+    long intervals = (long) ceil(simulation_time / metrics_interval);
+    
+    if (!recording_metrics)
+    {
+        return;
+    }
+    
+    recording_metrics = 0;
+    
+    FILE * metrics_output = fopen(metrics_file, "w");
+    
+    if (metrics_output == NULL)
+    {
+        fprintf(stderr, "Error while opening metrics file %s.\n", metrics_file);
+        exit(1);
+    }
+    
+    fprintf(metrics_output, "{\"simulation_time\":%.2f,\"interval\":%g,\"link_bandwidth_mbps\":%g,\n\"tasks\":{",
+            simulation_time, metrics_interval, analytic_bandwidth);
+            
+    for (i = 0; i < METRICS_TASK_TYPES; i++)
+    {
+        struct Histogram *histogram = &histograms[i];
+                
+        fprintf(metrics_output, "%s\n\"%s\":{\"count\":%ld,\"min\":%.3f,\"mean\":%.3f,\"p50\":%.3f,\"p95\":%.3f,\"p99\":%.3f,\"max\":%.3f}",
+                (i == 0) ? "" : ",",
+                task_names[i],
+                histogram->total,
+                histogram->min,
+                (histogram->total > 0) ? histogram->sum / histogram->total : 0,
+                histogram_percentile(histogram, 0.5),
+                histogram_percentile(histogram, 0.95),
+                histogram_percentile(histogram, 0.99),
+                histogram->max);
+                
+        if (histogram->total > 0)
+        {
+            XBT_INFO("%s tasks: %ld, p50 %.2f, p95 %.2f, p99 %.2f, max %.2f seconds",
+                     task_names[i], histogram->total,
+                     histogram_percentile(histogram, 0.5),
+                     histogram_percentile(histogram, 0.95),
+                     histogram_percentile(histogram, 0.99),
+                     histogram->max);
+        }
+    }
+            
+    fputs("},\n\"hosts\":[", metrics_output);
+        
+    for (i = 0; i < series_count; i++)
+    {
+        struct HostSeries *host_series = &series[i];
+            
+        if (host_series->host == NULL || !host_series->host->is_worker)
+        {
+            continue;
+        }
+            
+        long cores = MSG_host_get_core_number(host_series->host->host);
+            
+        fprintf(metrics_output, "%s\n{\"name\":\"%s\",\"cores\":%ld",
+                first_host ? "" : ",", host_series->host->host_name, cores);
+        write_utilization(metrics_output, "cpu", &host_series->busy_seconds, cores, intervals, simulation_time);
+        write_utilization(metrics_output, "link_in", &host_series->bytes_in, link_capacity, intervals, simulation_time);
+        write_utilization(metrics_output, "link_out", &host_series->bytes_out, link_capacity, intervals, simulation_time);
+        fputs("}", metrics_output);
+        first_host = 0;
+            
+        XBT_INFO("%s peak utilization: cpu %.1f%%, link in %.1f%%, link out %.1f%%",
+                 host_series->host->host_name,
+                 100 * get_peak(&host_series->busy_seconds, cores, simulation_time),
+                 100 * get_peak(&host_series->bytes_in, link_capacity, simulation_time),
+                 100 * get_peak(&host_series->bytes_out, link_capacity, simulation_time));
+    }
+        
+    fputs("\n]}\n", metrics_output);
+    fclose(metrics_output);
+    
+    for (i = 0; i < series_count; i++)
+    {
+        free_series(&series[i].busy_seconds);
+        free_series(&series[i].bytes_in);
+        free_series(&series[i].bytes_out);
+    }
+    
+    free(histograms);
+    free(series);
+    histograms = NULL;
+    series = NULL;
+}
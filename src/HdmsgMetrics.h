@@ -0,0 +1,90 @@
+//
+//  HdmsgMetrics.h
+//  HDMSG
+//
+
+#ifndef HDMSGMETRICS_H
+#define HDMSGMETRICS_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern char *metrics_file;
+extern double metrics_interval;
+extern int recording_metrics;
+
+// Tasks with a latency histogram
+#define METRICS_MAP 0
+#define METRICS_SHUFFLE 1
+#define METRICS_REDUCE 2
+#define METRICS_TASK_TYPES 3
+
+// Histogram buckets: 2^HISTOGRAM_SUB_BITS linear sub-buckets per power of two of microseconds,
+// so a recorded value is off by less than 1%, up to 2^HISTOGRAM_MAX_BITS microseconds
+#define HISTOGRAM_SUB_BITS 8
+#define HISTOGRAM_MAX_BITS 47
+#define HISTOGRAM_SIZE ((HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS + 2) << (HISTOGRAM_SUB_BITS - 1))
+
+// Metrics cost one test per call site when they are off
+#define METRICS_TASK(type, start_time) \
+    do { if (recording_metrics) { metricsTask((type), (start_time)); } } while (0)
+
+#define METRICS_BUSY(hdmsg_host, start_time) \
+    do { if (recording_metrics) { metricsBusy((hdmsg_host), (start_time)); } } while (0)
+
+#define METRICS_LINK(source, destination, start_time, bytes) \
+    do { if (recording_metrics) { metricsLink((source), (destination), (start_time), (bytes)); } } while (0)
+
+// Defined in HdmsgAnalytic.c
+extern double analytic_bandwidth;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// Task durations in microseconds, bucketed like an HdrHistogram
+struct Histogram
+{
+    long counts[HISTOGRAM_SIZE];
+    long total;
+    double min;                     // In seconds, exact
+    double max;
+    double sum;
+};
+
+// A quantity summed into intervals of metrics_interval seconds, grown as time passes
+struct TimeSeries
+{
+    double *values;
+    long length;
+    long capacity;
+};
+
+// One host's utilization over the simulation
+struct HostSeries
+{
+    struct HdmsgHost *host;
+    struct TimeSeries busy_seconds;     // Core-seconds held by tasks
+    struct TimeSeries bytes_in;         // Bytes received over the network
+    struct TimeSeries bytes_out;        // Bytes sent over the network
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void openMetrics();
+void closeMetrics();
+void metricsTask(int, double);
+void metricsBusy(struct HdmsgHost *, double);
+void metricsLink(struct HdmsgHost *, struct HdmsgHost *, double, double);
+
+void histogram_record(struct Histogram *, double);
+double histogram_percentile(struct Histogram *, double);
+
+#endif /* HdmsgMetrics_h */
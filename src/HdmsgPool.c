@@ -0,0 +1,83 @@
+//
+//  HdmsgPool.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "HdmsgPool.h"
+
+// Hosts, reducers, HDFS blocks and process names live as long as the simulation, so they
+// come from an arena that is never freed instead of one malloc each. A forked sweep
+// worker inherits the arena of its parent.
+static char *arena_block = NULL;
+static size_t arena_used = 0;
+static size_t arena_size = 0;
+
+static xbt_dict_t interned_names = NULL;
+
+/*
+ * Returns zeroed memory for an object that lives until the process exits
+ */
+void *arena_alloc(size_t size)
+{
+    // Keep every object aligned for any type
+    size = (size + 15) & ~((size_t) 15);
+    
+    if (arena_block == NULL || arena_used + size > arena_size)
+    {
+        arena_size = (size > ARENA_BLOCK_SIZE) ? size : ARENA_BLOCK_SIZE;
+        arena_block = xbt_malloc(arena_size);
+        arena_used = 0;
+    }
+    
+    void *object = arena_block + arena_used;
+    arena_used += size;
+    memset(object, 0, size);
+    
+    return object;
+}
+
+/*
+ * Returns the one copy of a formatted name, so names built again and again, like those
+ * of the processes started for every remote read, are only stored once
+ */
+char *intern_name(const char *format, ...)
+{
+    char name[INTERNED_NAME_SIZE];
+    va_list args;
+    
+    va_start(args, format);
+    vsnprintf(name, sizeof(name), format, args);
+    va_end(args);
+    
+    if (interned_names == NULL)
+    {
+        interned_names = xbt_dict_new();
+    }
+    
+    char *interned = xbt_dict_get_or_null(interned_names, name);
+    
+    if (interned == NULL)
+    {
+        interned = arena_alloc(strlen(name) + 1);
+        strcpy(interned, name);
+        xbt_dict_set(interned_names, name, interned, NULL);
+    }
+    
+    return interned;
+}
+
+/*
+ * Runs a computation on the current host and frees its task, which nothing else refers to
+ */
+msg_error_t execute_task(const char *name, double flops)
+{
+    msg_task_t task = MSG_task_create(name, flops, 0, NULL);
+    msg_error_t res = MSG_task_execute(task);
+    MSG_task_destroy(task);
+    
+    return res;
+}
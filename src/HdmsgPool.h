@@ -0,0 +1,30 @@
+//
+//  HdmsgPool.h
+//  HDMSG
+//
+
+#ifndef HDMSGPOOL_H
+#define HDMSGPOOL_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+
+//////////////////////
+// Constants
+//////////////////////
+
+// Objects are carved out of blocks this large, or one block per object if it is larger
+#define ARENA_BLOCK_SIZE (1 << 20)
+
+// Longest name intern_name() builds
+#define INTERNED_NAME_SIZE 256
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void *arena_alloc(size_t);
+char *intern_name(const char *, ...);
+msg_error_t execute_task(const char *, double);
+
+#endif /* HdmsgPool_h */
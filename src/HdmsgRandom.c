@@ -0,0 +1,45 @@
+//
+//  HdmsgRandom.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdint.h>
+#include "HdmsgRandom.h"
+
+// Every random choice in a simulation comes from this generator, so one seed reproduces a run.
+// It is a private xorshift64* rather than rand(), which SimGrid or libc may also draw from.
+unsigned long random_seed = 1;
+
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+
+void seedRandom(unsigned long seed)
+{
+    random_state = 0x9E3779B97F4A7C15ULL ^ ((uint64_t) seed * 0xBF58476D1CE4E5B9ULL);
+    
+    // The state must never be zero
+    if (random_state == 0)
+    {
+        random_state = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+/*
+ * Returns a uniformly distributed double in [0, 1)
+ */
+double random_uniform()
+{
+    random_state ^= random_state >> 12;
+    random_state ^= random_state << 25;
+    random_state ^= random_state >> 27;
+    
+    return ((random_state * 0x2545F4914F6CDD1DULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Returns a uniformly distributed integer in [0, n)
+ */
+long random_below(long n)
+{
+    return (long) (random_uniform() * n);
+}
@@ -0,0 +1,24 @@
+//
+//  HdmsgRandom.h
+//  HDMSG
+//
+
+#ifndef HDMSGRANDOM_H
+#define HDMSGRANDOM_H
+
+#include <stdio.h>
+
+//////////////////////
+// Constants
+//////////////////////
+extern unsigned long random_seed;
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void seedRandom(unsigned long);
+double random_uniform();
+long random_below(long);
+
+#endif /* HdmsgRandom_h */
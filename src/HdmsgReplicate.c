@@ -0,0 +1,284 @@
+//
+//  HdmsgReplicate.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <sys/time.h>
+#include "HdmsgReplicate.h"
+#include "HdmsgGroundTruth.h"
+
+// Each configuration runs at least replication_min replications, then replication_min more
+// at a time until the 95% confidence interval of its map, reduce and total times is
+// narrower than replication_ci_width of their means, or it has run 'replications'.
+int replications = 30;
+int replication_min = 5;
+double replication_ci_width = 0.02;
+
+static const char *metric_names[REPLICATION_METRICS] = { "map", "reduce", "total" };
+
+// Two-sided 95% Student t quantiles for 1 to 30 degrees of freedom
+static const double t_quantiles[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+static double get_t_quantile(long degrees)
+{
+    double z = 1.959964;
+    
+    if (degrees <= 30)
+    {
+        return t_quantiles[degrees - 1];
+    }
+    
+    // First two Cornish-Fisher terms, within 0.0001 of the exact value past 30 degrees of freedom
+    double z3 = z * z * z;
+    double z5 = z3 * z * z;
+    return z + (z3 + z) / (4 * degrees) + (5 * z5 + 16 * z3 + 3 * z) / (96.0 * degrees * degrees);
+}
+
+static double get_metric(struct SimResult *result, int metric)
+{
+    switch (metric)
+    {
+        case REPLICATION_MAP:
+            return result->sim_map;
+        case REPLICATION_REDUCE:
+            return result->sim_reduce;
+        default:
+            return result->simulation_time;
+    }
+}
+
+static void add_replication(struct ReplicationStats *stats, struct SimResult *result)
+{
+    int i;
+    
+    if (result->status != 0)
+    {
+        stats->failures++;
+        return;
+    }
+    
+    stats->runs++;
+    
+    for (i = 0; i < REPLICATION_METRICS; i++)
+    {
+        double value = get_metric(result, i);
+        double delta = value - stats->mean[i];
+        stats->mean[i] += delta / stats->runs;
+        stats->m2[i] += delta * (value - stats->mean[i]);
+    }
+}
+
+static double get_std_dev(struct ReplicationStats *stats, int metric)
+{
+    return (stats->runs > 1) ? sqrt(stats->m2[metric] / (stats->runs - 1)) : 0;
+}
+
+/*
+ * Returns half the width of the 95% confidence interval of a metric's mean
+ */
+static double get_half_width(struct ReplicationStats *stats, int metric)
+{
+    if (stats->runs < 2)
+    {
+        return 0;
+    }
+    
+    return get_t_quantile(stats->runs - 1) * get_std_dev(stats, metric) / sqrt(stats->runs);
+}
+
+static int is_converged(struct ReplicationStats *stats)
+{
+    int i;
+    
+    if (stats->runs < 2 || stats->runs < replication_min)
+    {
+        return 0;
+    }
+    
+    for (i = 0; i < REPLICATION_METRICS; i++)
+    {
+        if (2 * get_half_width(stats, i) > replication_ci_width * fabs(stats->mean[i]))
+        {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+static void write_report(FILE *report_file, struct ReplicationStats *stats, int count)
+{
+    int i, j;
+    
+    fprintf(report_file, "input_mb chunk_mb reducers seed runs failed");
+    
+    for (j = 0; j < REPLICATION_METRICS; j++)
+    {
+        fprintf(report_file, " %s_mean %s_sd %s_ci_low %s_ci_high",
+                metric_names[j], metric_names[j], metric_names[j], metric_names[j]);
+    }
+    
+    fprintf(report_file, " actual_exec converged\n");
+    
+    for (i = 0; i < count; i++)
+    {
+        fprintf(report_file, "%ld %ld %ld %lu %ld %ld",
+                stats[i].config.input_size, stats[i].config.hdfs_chunk_size, stats[i].config.reducers,
+                stats[i].config.seed, stats[i].runs, stats[i].failures);
+        
+        for (j = 0; j < REPLICATION_METRICS; j++)
+        {
+            fprintf(report_file, " %.2f %.2f %.2f %.2f",
+                    stats[i].mean[j],
+                    get_std_dev(&stats[i], j),
+                    stats[i].mean[j] - get_half_width(&stats[i], j),
+                    stats[i].mean[j] + get_half_width(&stats[i], j));
+        }
+        
+        fprintf(report_file, " %.2f %d\n", stats[i].config.actual_exec, stats[i].converged);
+    }
+}
+
+/*
+ * Runs seeded replications of the configured job, or of every configuration with cluster
+ * measurements, and reports the mean, standard deviation and 95% confidence interval of
+ * the map, reduce and total times.
+ *
+ * Replication k of a configuration is seeded with random_seed + k, so a replication gives
+ * the same times whichever worker runs it, and the number of replications each
+ * configuration needs does not depend on the number of workers.
+ */
+int runReplications(int all_configurations, double map_cf, double reduce_cf)
+{
+    int i, j, k;
+    int round = 0;
+    int count = 1;
+    int workers = get_worker_count(sweep_workers);
+    struct timeval start, end;
+    
+    struct SimResult *configs = xbt_new0(struct SimResult, getMeasuredConfigCount() + 1);
+    
+    if (all_configurations)
+    {
+        count = getMeasuredConfigs(configs, map_cf, reduce_cf);
+        
+        if (count == 0)
+        {
+            fprintf(stderr, "There are no cluster measurements for platform %s to replicate.\n", ground_truth_platform);
+            free(configs);
+            return 1;
+        }
+    }
+    else
+    {
+        initSimResult(&configs[0], map_cf, reduce_cf);
+    }
+    
+    struct ReplicationStats *stats = xbt_new0(struct ReplicationStats, count);
+    struct SimResult *runs = xbt_new0(struct SimResult, count * replications);
+    int *owners = xbt_new0(int, count * replications);
+    
+    for (i = 0; i < count; i++)
+    {
+        stats[i].config = configs[i];
+        getActualTimes(configs[i].input_size, configs[i].hdfs_chunk_size, configs[i].reducers,
+                       &stats[i].config.actual_map, &stats[i].config.actual_reduce, &stats[i].config.actual_exec);
+    }
+    
+    printf("\nReplicating %d configuration(s) on %d workers, %d to %d runs each, until the 95%% CI is within %.1f%% of the mean\n",
+           count, workers, replication_min, replications, 100 * replication_ci_width);
+    
+    gettimeofday(&start, NULL);
+    
+    while (1)
+    {
+        int run_count = 0;
+        int converged = 0;
+        
+        // The next replications of every configuration that is not settled yet
+        for (i = 0; i < count; i++)
+        {
+            long attempted = stats[i].runs + stats[i].failures;
+            
+            for (k = 0; !stats[i].converged && k < replication_min && attempted + k < replications; k++)
+            {
+                runs[run_count] = stats[i].config;
+                runs[run_count].seed = stats[i].config.seed + attempted + k;
+                owners[run_count] = i;
+                run_count++;
+            }
+        }
+        
+        if (run_count == 0)
+        {
+            break;
+        }
+        
+        runParallel(runs, run_count, workers, runSimulation);
+        round++;
+        
+        // In seed order, so the sums do not depend on which replication finished first
+        for (j = 0; j < run_count; j++)
+        {
+            add_replication(&stats[owners[j]], &runs[j]);
+        }
+        
+        for (i = 0; i < count; i++)
+        {
+            stats[i].converged = is_converged(&stats[i]);
+            converged += stats[i].converged;
+        }
+        
+        printf("Round %d: %d runs, %d of %d configuration(s) within the target\n", round, run_count, converged, count);
+    }
+    
+    gettimeofday(&end, NULL);
+    
+    printf("\nConfig\t\tRuns\tMap\t\t\tReduce\t\t\tSim_Time\t\tActual\n");
+    
+    for (i = 0; i < count; i++)
+    {
+        printf("%ld-%ld-%ld\t%ld\t%.2f +- %.2f\t\t%.2f +- %.2f\t\t%.2f +- %.2f\t\t%.2f%s\n",
+               stats[i].config.input_size, stats[i].config.hdfs_chunk_size, stats[i].config.reducers,
+               stats[i].runs,
+               stats[i].mean[REPLICATION_MAP], get_half_width(&stats[i], REPLICATION_MAP),
+               stats[i].mean[REPLICATION_REDUCE], get_half_width(&stats[i], REPLICATION_REDUCE),
+               stats[i].mean[REPLICATION_TOTAL], get_half_width(&stats[i], REPLICATION_TOTAL),
+               stats[i].config.actual_exec,
+               stats[i].converged ? "" : "\t(CI above the target)");
+    }
+    
+    printf("Completed in %.2f seconds, results in HDMSG_replications.txt\n",
+           (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6);
+    
+    FILE * report_file = fopen("HDMSG_replications.txt", "w");
+    
+    if (report_file == NULL)
+    {
+        fprintf(stderr, "Error while opening HDMSG_replications.txt.\n");
+        exit(1);
+    }
+    
+    write_report(report_file, stats, count);
+    fclose(report_file);
+    
+    int failures = 0;
+    
+    for (i = 0; i < count; i++)
+    {
+        failures += (stats[i].runs == 0) ? 1 : 0;
+    }
+    
+    free(configs);
+    free(stats);
+    free(runs);
+    free(owners);
+    
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+//
+//  HdmsgReplicate.h
+//  HDMSG
+//
+
+#ifndef HDMSGREPLICATE_H
+#define HDMSGREPLICATE_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgSweep.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern int replications;
+extern int replication_min;
+extern double replication_ci_width;
+
+// Times summarized over the replications of a configuration
+#define REPLICATION_MAP 0
+#define REPLICATION_REDUCE 1
+#define REPLICATION_TOTAL 2
+#define REPLICATION_METRICS 3
+
+// Defined in HdmsgRandom.c
+extern unsigned long random_seed;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// Running mean and variance (Welford) of each time over the replications of one configuration
+struct ReplicationStats
+{
+    struct SimResult config;    // Job and calibration factors every replication shares
+    long runs;                  // Replications that completed
+    long failures;
+    double mean[REPLICATION_METRICS];
+    double m2[REPLICATION_METRICS];     // Sum of squared differences from the mean
+    int converged;              // 1 once every confidence interval is narrow enough
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+int runReplications(int, double, double);
+
+#endif /* HdmsgReplicate_h */
@@ -0,0 +1,156 @@
+//
+//  HdmsgSkew.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HdmsgSkew.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Keys are numbered 0 .. key_count - 1 and hash partitioned, so key k goes to reducer k % reducers.
+// "uniform" gives every reducer the same share, as the simulation always assumed.
+// "zipf" weighs key k by 1 / (k + 1)^key_zipf_s.
+// "histogram" reads one weight per key, one per line, from key_histogram_file.
+char *key_distribution = "uniform";
+double key_zipf_s = 1.0;
+long key_count = 1000;
+char *key_histogram_file = NULL;
+
+/*
+ * Reads key weights from key_histogram_file. Returns the number of keys read.
+ */
+static long read_key_histogram(double **weights)
+{
+    long count = 0;
+    long capacity = 64;
+    double weight;
+    
+    FILE * histogram_file = fopen(key_histogram_file, "r");
+    
+    if (histogram_file == NULL)
+    {
+        fprintf(stderr, "Error while opening key histogram file: %s\n", key_histogram_file);
+        exit(1);
+    }
+    
+    *weights = malloc(capacity * sizeof(double));
+    
+    while (fscanf(histogram_file, "%lf", &weight) == 1)
+    {
+        if (count == capacity)
+        {
+            capacity *= 2;
+            *weights = realloc(*weights, capacity * sizeof(double));
+        }
+        (*weights)[count++] = weight;
+    }
+    
+    fclose(histogram_file);
+    
+    return count;
+}
+
+/*
+ * Returns the share of the map output each of a job's partitions receives, indexed by
+ * HdmsgReducer partition.
+ */
+double *computeReducerShares(long partitions)
+{
+    long i;
+    long keys = 0;
+    double total = 0;
+    double *weights = NULL;
+    double *reducer_shares = calloc(partitions, sizeof(double));
+    
+    if (strcmp(key_distribution, "zipf") == 0)
+    {
+        keys = key_count;
+        weights = malloc(keys * sizeof(double));
+        for (i = 0; i < keys; i++)
+        {
+            weights[i] = 1 / pow(i + 1, key_zipf_s);
+        }
+    }
+    else if (strcmp(key_distribution, "histogram") == 0)
+    {
+        if (key_histogram_file == NULL)
+        {
+            fprintf(stderr, "The histogram key distribution needs a key_histogram_file\n");
+            exit(1);
+        }
+        
+        keys = read_key_histogram(&weights);
+    }
+    else if (strcmp(key_distribution, "uniform") != 0)
+    {
+        fprintf(stderr, "Unknown key distribution: %s\n", key_distribution);
+        exit(1);
+    }
+    
+    // A workload job may have no reducers, and so no partitions
+    for (i = 0; i < keys && partitions > 0; i++)
+    {
+        reducer_shares[i % partitions] += weights[i];
+        total += weights[i];
+    }
+    
+    for (i = 0; i < partitions; i++)
+    {
+        reducer_shares[i] = (total > 0) ? reducer_shares[i] / total : 1.0 / partitions;
+    }
+    
+    free(weights);
+    return reducer_shares;
+}
+
+double get_reducer_share(struct HdmsgJob *job, long partition)
+{
+    return job->reducer_shares[partition];
+}
+
+long get_largest_partition(struct HdmsgJob *job)
+{
+    long i;
+    long largest = 0;
+    
+    for (i = 1; i < job->reducers; i++)
+    {
+        if (job->reducer_shares[i] > job->reducer_shares[largest])
+        {
+            largest = i;
+        }
+    }
+    
+    return largest;
+}
+
+/*
+ * Writes one line per reducer of the job: partition, host, share, bytes received and finish time.
+ */
+void writeReducerReport(FILE *output_file, struct HdmsgJob *job)
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    struct HdmsgReducer * reducer;
+    xbt_dict_cursor_t cursor = NULL;
+    xbt_fifo_item_t bucket;
+    
+    fprintf(output_file, "partition host share bytes finish_time\n");
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        xbt_fifo_foreach(get_job_host(job, hdmsg_host)->reducers, bucket, reducer, struct HdmsgReducer *)
+        {
+            fprintf(output_file, "%ld %s %.4f %.0f %.2f\n",
+                    reducer->partition,
+                    hdmsg_host->host_name,
+                    get_reducer_share(job, reducer->partition),
+                    reducer->received_bytes,
+                    reducer->finish_time);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+//
+//  HdmsgSkew.h
+//  HDMSG
+//
+
+#ifndef HDMSGSKEW_H
+#define HDMSGSKEW_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern char *key_distribution;
+extern double key_zipf_s;
+extern long key_count;
+extern char *key_histogram_file;
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+double *computeReducerShares(long);
+double get_reducer_share(struct HdmsgJob *, long);
+long get_largest_partition(struct HdmsgJob *);
+void writeReducerReport(FILE *, struct HdmsgJob *);
+
+#endif /* HdmsgSkew_h */
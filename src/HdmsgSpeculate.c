@@ -0,0 +1,686 @@
+//
+//  HdmsgSpeculate.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "HdmsgSpeculate.h"
+#include "HdmsgTrace.h"
+#include "HdmsgRandom.h"
+#include "HdmsgPool.h"
+#include "HdmsgTopology.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Stragglers: straggler_host_fraction of the workers run every task straggler_factor times
+// slower, and each task attempt is slowed by the same factor with probability straggler_task_fraction.
+double straggler_task_fraction = 0;
+double straggler_host_fraction = 0;
+double straggler_factor = 3;
+
+// Speculation: every speculation_interval seconds the speculator may launch a backup copy of
+// a running task on a host with a free core. The first copy to finish wins and the other is killed.
+// "default" backs up tasks whose progress is 0.2 behind the average of their phase after a minute,
+// like Hadoop's original speculator. "late" backs up the slow tasks (progress rate in the lowest
+// quartile) with the longest estimated time left, on hosts that are not slow, as in LATE.
+// At most speculative_cap of the cores run backups at a time.
+int speculative_execution = 0;
+char *speculation_policy = "late";
+double speculation_interval = 10;
+double speculative_cap = 0.1;
+
+#define DEFAULT_PROGRESS_GAP 0.2
+#define DEFAULT_MIN_RUNTIME  60
+#define LATE_SLOW_TASK_QUANTILE 0.25
+#define LATE_SLOW_NODE_MARGIN 1.25
+
+xbt_fifo_t running_attempts = NULL;
+long running_backups = 0;
+
+// One speculator serves every job that is running
+static msg_process_t speculator_process = NULL;
+static int speculating_jobs = 0;
+
+// Per phase statistics
+long speculated_tasks[2];
+long backup_wins[2];
+double wasted_core_seconds[2];
+double backup_bytes[2];
+double phase_end[2];                // Last task completion
+double phase_end_without[2];        // Estimated last completion had no backup run
+
+/*
+ * Marks straggler_host_fraction of the workers, chosen at random, as stragglers
+ */
+void chooseStragglerHosts()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    xbt_dynar_t workers = xbt_dynar_new(sizeof(struct HdmsgHost *), NULL);
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            xbt_dynar_push(workers, &hdmsg_host);
+        }
+    }
+    
+    long stragglers = lround(straggler_host_fraction * xbt_dynar_length(workers));
+    
+    while (stragglers > 0 && !xbt_dynar_is_empty(workers))
+    {
+        xbt_dynar_remove_at(workers, random_below(xbt_dynar_length(workers)), &hdmsg_host);
+        hdmsg_host->slowdown = straggler_factor;
+        XBT_INFO("%s is a straggler, %gx slower", hdmsg_host->host_name, straggler_factor);
+        stragglers--;
+    }
+    
+    xbt_dynar_free(&workers);
+}
+
+/*
+ * Returns how many times slower than normal an attempt on this host runs
+ */
+static double get_slowdown(struct HdmsgHost *this_host)
+{
+    double slowdown = this_host->slowdown;
+    
+    if (straggler_task_fraction > 0 && random_uniform() < straggler_task_fraction)
+    {
+        slowdown *= straggler_factor;
+    }
+    
+    return slowdown;
+}
+
+/*
+ * Progress of an attempt's task, from 0 to 1
+ */
+static double get_progress(msg_task_t task, double flops)
+{
+    return (flops > 0) ? 1 - MSG_task_get_flops_amount(task) / flops : 1;
+}
+
+/*
+ * Records the completion of a task for the tail latency report. A task whose original
+ * attempt lost is estimated to have needed its remaining work at its observed rate.
+ */
+static void record_completion(struct HdmsgAttempt *attempt, int backup_won)
+{
+    double now = MSG_get_clock();
+    double end_without = now;
+    
+    if (backup_won)
+    {
+        double progress = get_progress(attempt->task, attempt->flops);
+        double elapsed = now - attempt->start_time;
+        end_without = (progress > 0) ? attempt->start_time + elapsed / progress : INFINITY;
+    }
+    
+    phase_end[attempt->phase] = fmax(phase_end[attempt->phase], now);
+    phase_end_without[attempt->phase] = fmax(phase_end_without[attempt->phase], end_without);
+    
+    attempt->host->finished_attempts++;
+    attempt->host->finished_attempt_time += now - attempt->start_time;
+}
+
+/** Drops a copy's hold on the attempt, which is freed once both copies are done with it */
+static void release_attempt(struct HdmsgAttempt *attempt)
+{
+    if (--attempt->copies == 0)
+    {
+        MSG_sem_destroy(attempt->backup_done);
+        free(attempt);
+    }
+}
+
+/** Accounts for the end of an attempt's backup, whether it ran to the end or was killed */
+static void end_backup(struct HdmsgAttempt *attempt)
+{
+    attempt->backup_host->running_tasks--;
+    attempt->backup_process = NULL;
+    running_backups--;
+    release_attempt(attempt);
+}
+
+/*
+ * Stops the backup of an attempt whose original finished first. A backup still fetching its
+ * input is killed, so its transfer does not keep it running after the job.
+ */
+static void stop_backup(struct HdmsgAttempt *attempt)
+{
+    if (attempt->backup_process == NULL)
+    {
+        return;
+    }
+    
+    if (attempt->backup_task != NULL)
+    {
+        MSG_task_cancel(attempt->backup_task);
+        return;
+    }
+    
+    MSG_process_kill(attempt->backup_process);
+    end_backup(attempt);
+}
+
+/*
+ * Runs the original attempt of a task. Returns 1 if it finished first, or 0 if a backup won.
+ */
+static int run_original(struct HdmsgAttempt *attempt)
+{
+    msg_error_t res;
+    
+    attempt->start_time = MSG_get_clock();
+    xbt_fifo_push(running_attempts, attempt);
+    attempt->host->running_tasks++;
+    
+    res = MSG_task_execute(attempt->task);
+    simulation_events++;
+    attempt->host->running_tasks--;
+    
+    if (res == MSG_OK && !attempt->finished)
+    {
+        attempt->finished = 1;
+        xbt_fifo_remove(running_attempts, attempt);
+        record_completion(attempt, 0);
+        stop_backup(attempt);
+        release_attempt(attempt);
+        
+        return 1;
+    }
+    
+    wasted_core_seconds[attempt->phase] += MSG_get_clock() - attempt->start_time;
+    
+    // A winning map backup still has to send its output before this task is done
+    if (attempt->phase == PHASE_MAP)
+    {
+        MSG_sem_acquire(attempt->backup_done);
+        simulation_events++;
+    }
+    
+    release_attempt(attempt);
+    
+    return 0;
+}
+
+static struct HdmsgAttempt *new_attempt(int phase, struct HdmsgJob *job, struct HdmsgHost *this_host, msg_task_t task, double cost, double flops)
+{
+    struct HdmsgAttempt *attempt = xbt_new0(struct HdmsgAttempt, 1);
+    
+    attempt->phase = phase;
+    attempt->job = job;
+    attempt->host = this_host;
+    attempt->task = task;
+    attempt->cost = cost;
+    attempt->flops = flops;
+    attempt->backup_done = MSG_sem_init(0);
+    attempt->copies = 1;
+    
+    return attempt;
+}
+
+/*
+ * Executes a map task on this host, with any straggler slowdown and possibly a backup copy.
+ * Returns 1 if this attempt produced the map output, or 0 if a backup produced and sent it.
+ */
+int executeMapTask(struct HdmsgJobHost *this_host, msg_task_t map_task)
+{
+    double cost = MSG_task_get_flops_amount(map_task);
+    double flops = cost * get_slowdown(this_host->host);
+    MSG_task_set_flops_amount(map_task, flops);
+    
+    if (!speculative_execution)
+    {
+        MSG_task_execute(map_task);
+        simulation_events++;
+        return 1;
+    }
+    
+    struct HdmsgAttempt *attempt = new_attempt(PHASE_MAP, this_host->job, this_host->host, map_task, cost, flops);
+    attempt->block = MSG_task_get_data(map_task);
+    
+    return run_original(attempt);
+}
+
+/*
+ * Executes a reducer's reduce task, with any straggler slowdown and possibly a backup copy.
+ * Returns 1 if this attempt finished first.
+ */
+int executeReduceTask(struct HdmsgReducer *reducer, double cost)
+{
+    int won;
+    double flops = cost * get_slowdown(reducer->host);
+    msg_task_t reduce_task = MSG_task_create("reduce", flops, 0, NULL);
+    
+    if (!speculative_execution)
+    {
+        MSG_task_execute(reduce_task);
+        simulation_events++;
+        MSG_task_destroy(reduce_task);
+        return 1;
+    }
+    
+    struct HdmsgAttempt *attempt = new_attempt(PHASE_REDUCE, reducer->job, reducer->host, reduce_task, cost, flops);
+    attempt->reducer = reducer;
+    
+    won = run_original(attempt);
+    MSG_task_destroy(reduce_task);
+    
+    return won;
+}
+
+/*
+ * Sends a winning map backup's output straight to the reducers, since the senders on its
+ * host may already be gone
+ */
+static void send_backup_output(struct HdmsgAttempt *attempt)
+{
+    long i;
+    unsigned int cpt;
+    msg_comm_t comm;
+    struct HdmsgReducer * reducer;
+    struct HdmsgJob * job = attempt->job;
+    xbt_dynar_t comms;
+    
+    // Pulling reducers fetch it from the backup's host like any map output
+    if (pull_shuffle)
+    {
+        partition_map_task(get_job_host(job, attempt->backup_host), attempt->block);
+        return;
+    }
+    
+    comms = xbt_dynar_new(sizeof(msg_comm_t), NULL);
+    double start_time = MSG_get_clock();
+    
+    for (i = 0; i < job->reducer_table_size; i++)
+    {
+        reducer = job->reducer_table[i];
+        msg_task_t shuffle_task = MSG_task_create("shuffle", 0, get_bytes_to_shuffle(job, reducer->partition), reducer);
+        comm = MSG_task_isend(shuffle_task, reducer->mailbox);
+        xbt_dynar_push_as(comms, msg_comm_t, comm);
+    }
+    
+    xbt_dynar_foreach(comms, cpt, comm)
+    {
+        MSG_comm_wait(comm, -1);
+        MSG_comm_destroy(comm);
+        simulation_events++;
+        
+        reducer = job->reducer_table[cpt];
+        recordShuffleTraffic(attempt->backup_host, reducer->host, start_time, get_bytes_to_shuffle(job, reducer->partition));
+    }
+    
+    xbt_dynar_free(&comms);
+}
+
+/** Backup Attempt Process: a speculative copy of a running task */
+int speculativeAttempt(int argc, char * argv[])
+{
+    int locality;
+    msg_error_t res;
+    struct HdmsgAttempt *attempt = MSG_process_get_data(MSG_process_self());
+    struct HdmsgHost *this_host = attempt->backup_host;
+    
+    this_host->running_tasks++;
+    
+    // Fetch the input: the map's block from the replica a map here would read, unless this host
+    // holds one, or the reducer's shuffled data
+    if (attempt->phase == PHASE_MAP)
+    {
+        struct HdmsgHost *source = get_block_source(attempt->block, this_host, &locality);
+        
+        if (source != NULL)
+        {
+            receiveFromHost(source, attempt->job->hdfs_chunk_size_bytes);
+            backup_bytes[PHASE_MAP] += attempt->job->hdfs_chunk_size_bytes;
+        }
+    }
+    else
+    {
+        receiveFromHost(attempt->host, attempt->reducer->received_bytes);
+        backup_bytes[PHASE_REDUCE] += attempt->reducer->received_bytes;
+    }
+    
+    if (!attempt->finished)
+    {
+        attempt->backup_start_time = MSG_get_clock();
+        attempt->backup_task = MSG_task_create("backup", attempt->cost * get_slowdown(this_host), 0, NULL);
+        
+        res = MSG_task_execute(attempt->backup_task);
+        simulation_events++;
+        
+        if (res == MSG_OK && !attempt->finished)
+        {
+            attempt->finished = 1;
+            attempt->backup_won = 1;
+            backup_wins[attempt->phase]++;
+            xbt_fifo_remove(running_attempts, attempt);
+            record_completion(attempt, 1);
+            
+            XBT_INFO("%s backup beat the original on %s", MSG_process_get_name(MSG_process_self()), attempt->host->host_name);
+            MSG_task_cancel(attempt->task);
+            
+            if (attempt->phase == PHASE_MAP)
+            {
+                if (compress_cost_per_mb > 0)
+                {
+                    execute_task("compress", get_compress_cost(this_host->host, attempt->job));
+                    simulation_events++;
+                }
+                
+                send_backup_output(attempt);
+                map_completed(attempt->job);
+                MSG_sem_release(attempt->backup_done);
+            }
+        }
+        else
+        {
+            wasted_core_seconds[attempt->phase] += MSG_get_clock() - attempt->backup_start_time;
+        }
+        
+        TRACE_SPAN("speculation", attempt->backup_won ? "backup" : "killed backup", attempt->backup_start_time, 0);
+        MSG_task_destroy(attempt->backup_task);
+        attempt->backup_task = NULL;
+    }
+    
+    end_backup(attempt);
+    
+    return 0;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/*
+ * Mean attempt duration over every host, for LATE's slow node test
+ */
+static double mean_attempt_time()
+{
+    int i;
+    struct HdmsgHost * hdmsg_host;
+    long attempts = 0;
+    double time = 0;
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        attempts += hdmsg_host->finished_attempts;
+        time += hdmsg_host->finished_attempt_time;
+    }
+    
+    return (attempts > 0) ? time / attempts : 0;
+}
+
+/*
+ * Returns a worker with a free core to run a backup of the attempt, preferring one that
+ * holds a replica of a map's block, then the least busy. Returns NULL if there is none.
+ */
+static struct HdmsgHost *pick_backup_host(struct HdmsgAttempt *attempt, int late)
+{
+    int i;
+    int r;
+    struct HdmsgHost * hdmsg_host;
+    struct HdmsgHost * best = NULL;
+    int best_local = 0;
+    double mean_time = mean_attempt_time();
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        if (!hdmsg_host->is_worker || hdmsg_host == attempt->host ||
+            hdmsg_host->running_tasks >= MSG_host_get_core_number(hdmsg_host->host))
+        {
+            continue;
+        }
+        
+        // LATE does not put backups on hosts whose tasks have been slow
+        if (late && hdmsg_host->finished_attempts > 0 &&
+            hdmsg_host->finished_attempt_time / hdmsg_host->finished_attempts > LATE_SLOW_NODE_MARGIN * mean_time)
+        {
+            continue;
+        }
+        
+        int local = 0;
+        for (r = 0; attempt->phase == PHASE_MAP && r < attempt->block->replica_count; r++)
+        {
+            local |= (attempt->block->replicas[r] == hdmsg_host);
+        }
+        
+        if (best == NULL || local > best_local ||
+            (local == best_local && hdmsg_host->running_tasks < best->running_tasks))
+        {
+            best = hdmsg_host;
+            best_local = local;
+        }
+    }
+    
+    return best;
+}
+
+/*
+ * Keeps in best the running attempt of a job's phase that most needs a backup under the
+ * speculation policy, if it scores higher. Tasks are only compared with the same phase of
+ * their own job.
+ */
+static void pick_in_phase(struct HdmsgJob *job, int phase, int late, struct HdmsgAttempt **best, double *best_score)
+{
+    long n;
+    long count = 0;
+    double now = MSG_get_clock();
+    double total_progress = 0;
+    struct HdmsgAttempt *attempt;
+    xbt_fifo_item_t bucket;
+    double *rates = xbt_new(double, xbt_fifo_size(running_attempts) + 1);
+    
+    xbt_fifo_foreach(running_attempts, bucket, attempt, struct HdmsgAttempt *)
+    {
+        if (attempt->job == job && attempt->phase == phase && now > attempt->start_time)
+        {
+            double progress = get_progress(attempt->task, attempt->flops);
+            total_progress += progress;
+            rates[count++] = progress / (now - attempt->start_time);
+        }
+    }
+    
+    if (count == 0)
+    {
+        free(rates);
+        return;
+    }
+    
+    qsort(rates, count, sizeof(double), compare_doubles);
+    n = (long) (LATE_SLOW_TASK_QUANTILE * (count - 1));
+    double slow_rate = rates[n];
+    double mean_progress = total_progress / count;
+    free(rates);
+    
+    xbt_fifo_foreach(running_attempts, bucket, attempt, struct HdmsgAttempt *)
+    {
+        if (attempt->job != job || attempt->phase != phase || attempt->backup_host != NULL || now <= attempt->start_time)
+        {
+            continue;
+        }
+        
+        double elapsed = now - attempt->start_time;
+        double progress = get_progress(attempt->task, attempt->flops);
+        double rate = progress / elapsed;
+        double score;
+        
+        if (late)
+        {
+            // Longest estimated time left among the slow tasks
+            if (count < 2 || rate > slow_rate)
+            {
+                continue;
+            }
+            score = (rate > 0) ? (1 - progress) / rate : INFINITY;
+        }
+        else
+        {
+            // Furthest behind the phase's average progress
+            if (elapsed < DEFAULT_MIN_RUNTIME || progress > mean_progress - DEFAULT_PROGRESS_GAP)
+            {
+                continue;
+            }
+            score = mean_progress - progress;
+        }
+        
+        if (*best == NULL || score > *best_score)
+        {
+            *best = attempt;
+            *best_score = score;
+        }
+    }
+}
+
+/*
+ * Returns the running attempt that most needs a backup under the speculation policy,
+ * or NULL if none qualifies
+ */
+static struct HdmsgAttempt *pick_attempt_to_back_up(int late)
+{
+    int phase;
+    unsigned int cpt;
+    struct HdmsgJob *job;
+    struct HdmsgAttempt *attempt;
+    struct HdmsgAttempt *best = NULL;
+    double best_score = 0;
+    xbt_fifo_item_t bucket;
+    xbt_dynar_t jobs = xbt_dynar_new(sizeof(struct HdmsgJob *), NULL);
+    
+    // The jobs with running attempts, in the order their first attempt started
+    xbt_fifo_foreach(running_attempts, bucket, attempt, struct HdmsgAttempt *)
+    {
+        if (!xbt_dynar_member(jobs, &attempt->job))
+        {
+            xbt_dynar_push(jobs, &attempt->job);
+        }
+    }
+    
+    xbt_dynar_foreach(jobs, cpt, job)
+    {
+        for (phase = PHASE_MAP; phase <= PHASE_REDUCE; phase++)
+        {
+            pick_in_phase(job, phase, late, &best, &best_score);
+        }
+    }
+    
+    xbt_dynar_free(&jobs);
+    
+    return best;
+}
+
+/*
+ * Launches backups while the policy finds slow tasks, hosts have free cores and the cap allows
+ */
+static void speculate()
+{
+    int i;
+    struct HdmsgHost * hdmsg_host;
+    long total_cores = 0;
+    int late = (strcmp(speculation_policy, "late") == 0);
+    
+    foreach_hdmsg_host(i, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            total_cores += MSG_host_get_core_number(hdmsg_host->host);
+        }
+    }
+    
+    long cap = (long) fmax(1, floor(speculative_cap * total_cores));
+    
+    while (running_backups < cap)
+    {
+        struct HdmsgAttempt *attempt = pick_attempt_to_back_up(late);
+        if (attempt == NULL)
+        {
+            return;
+        }
+        
+        attempt->backup_host = pick_backup_host(attempt, late);
+        if (attempt->backup_host == NULL)
+        {
+            return;
+        }
+        
+        speculated_tasks[attempt->phase]++;
+        running_backups++;
+        attempt->copies++;
+        
+        char *name = intern_name("%s-Backup-of-%s", attempt->backup_host->host_name, attempt->host->host_name);
+        XBT_INFO("Launching %s", name);
+        attempt->backup_process = MSG_process_create(name, speculativeAttempt, attempt, attempt->backup_host->host);
+    }
+}
+
+/** Speculator Process: checks the running tasks every speculation_interval until killed */
+int speculator(int argc, char * argv[])
+{
+    while (1)
+    {
+        MSG_process_sleep(speculation_interval);
+        simulation_events++;
+        speculate();
+    }
+    
+    return 0;
+}
+
+/** Starts the speculator for a job, unless it already runs for another one */
+void startSpeculator(struct HdmsgHost *master)
+{
+    xbt_assert(strcmp(speculation_policy, "late") == 0 || strcmp(speculation_policy, "default") == 0,
+               "Unknown speculation policy: %s", speculation_policy);
+    
+    if (speculating_jobs++ > 0)
+    {
+        return;
+    }
+    
+    if (running_attempts == NULL)
+    {
+        running_attempts = xbt_fifo_new();
+    }
+    
+    speculator_process = MSG_process_create("Speculator", speculator, NULL, master->host);
+}
+
+/** Stops the speculator once the last job it serves is done */
+void stopSpeculator()
+{
+    if (--speculating_jobs == 0)
+    {
+        MSG_process_kill(speculator_process);
+        speculator_process = NULL;
+    }
+}
+
+/*
+ * Logs what speculation cost and how much of each phase's tail it removed
+ */
+void logSpeculationReport()
+{
+    int phase;
+    const char *phase_names[2] = { "Map", "Reduce" };
+    
+    for (phase = PHASE_MAP; phase <= PHASE_REDUCE; phase++)
+    {
+        XBT_INFO("%s speculation: %ld backups, %ld won, last task at %.2f (estimated %.2f without backups), %.2f core-seconds and %.0f bytes spent on backups",
+                 phase_names[phase],
+                 speculated_tasks[phase],
+                 backup_wins[phase],
+                 phase_end[phase],
+                 phase_end_without[phase],
+                 wasted_core_seconds[phase],
+                 backup_bytes[phase]);
+    }
+}
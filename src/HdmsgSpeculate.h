@@ -0,0 +1,81 @@
+//
+//  HdmsgSpeculate.h
+//  HDMSG
+//
+
+#ifndef HDMSGSPECULATE_H
+#define HDMSGSPECULATE_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+#include "HdmsgHdfs.h"
+
+//////////////////////
+// Constants
+//////////////////////
+#define PHASE_MAP    0
+#define PHASE_REDUCE 1
+
+extern double straggler_task_fraction;
+extern double straggler_host_fraction;
+extern double straggler_factor;
+
+extern int speculative_execution;
+extern char *speculation_policy;
+extern double speculation_interval;
+extern double speculative_cap;
+
+// Defined in HDMSG.c
+extern long simulation_events;
+extern double compress_cost_per_mb;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// One map or reduce task while it runs, with the backup copy speculation may launch for it
+struct HdmsgAttempt
+{
+    int phase;                      // PHASE_MAP or PHASE_REDUCE
+    struct HdmsgJob *job;
+    struct HdmsgHost *host;         // Host of the original attempt
+    struct HdfsBlock *block;        // Map input
+    struct HdmsgReducer *reducer;   // Reduce partition
+    double cost;                    // Flops of the task on a host without slowdown
+    
+    msg_task_t task;                // The original attempt
+    double flops;
+    double start_time;
+    
+    struct HdmsgHost *backup_host;  // NULL until a backup is launched
+    msg_process_t backup_process;   // NULL once the backup has ended
+    msg_task_t backup_task;
+    double backup_start_time;
+    
+    int finished;                   // Set by whichever attempt completes first
+    int backup_won;
+    msg_sem_t backup_done;          // Released by a winning map backup once its output is sent
+    int copies;                     // Copies still using the attempt, freed when none is left
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void chooseStragglerHosts();
+int executeMapTask(struct HdmsgJobHost *, msg_task_t);
+int executeReduceTask(struct HdmsgReducer *, double);
+void startSpeculator(struct HdmsgHost *);
+void stopSpeculator();
+void logSpeculationReport();
+
+int speculator(int argc, char * argv[]);
+int speculativeAttempt(int argc, char * argv[]);
+
+// Defined in HDMSG.c
+double get_compress_cost(msg_host_t, struct HdmsgJob *);
+void map_completed(struct HdmsgJob *);
+
+#endif /* HdmsgSpeculate_h */
@@ -0,0 +1,205 @@
+//
+//  HdmsgSweep.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "HdmsgSweep.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Same grid as exhaustiveSearch.py: 0.8 to 1.2 in steps of 0.01 for both factors
+double sweep_min = 0.8;
+double sweep_max = 1.2;
+double sweep_step = 0.01;
+int sweep_workers = 0;          // 0 = one worker per online core
+
+/*
+ * Returns the number of worker processes to run at once
+ */
+int get_worker_count(int requested)
+{
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    
+    if (requested > 0)
+    {
+        return requested;
+    }
+    
+    return (cores > 0) ? (int) cores : 1;
+}
+
+/*
+ * Evaluates every entry of results, at most 'workers' at a time.
+ *
+ * MSG_main() can only run once per process, so each point runs in a child forked after the
+ * platform and config have been parsed. The child inherits the initialized environment,
+ * runs one simulation and writes its SimResult back through a pipe. Results are stored at
+ * their own index, so the output order does not depend on which child finishes first.
+ *
+ * Returns the number of points that failed.
+ */
+int runParallel(struct SimResult *results, int count, int workers, void (*simulate)(struct SimResult *))
+{
+    int i, status;
+    int next = 0;
+    int running = 0;
+    int failures = 0;
+    
+    pid_t *pids = xbt_new0(pid_t, count);
+    int *pipes = xbt_new0(int, count);
+    
+    // Anything still buffered would otherwise be written once by every child
+    fflush(stdout);
+    fflush(stderr);
+    
+    while (next < count || running > 0)
+    {
+        while (running < workers && next < count)
+        {
+            int fd[2];
+            xbt_assert(pipe(fd) == 0, "pipe failed: Sweep");
+            
+            pid_t pid = fork();
+            xbt_assert(pid >= 0, "fork failed: Sweep");
+            
+            if (pid == 0)
+            {
+                close(fd[0]);
+                xbt_log_control_set("root.thres:critical");
+                
+                simulate(&results[next]);
+                
+                ssize_t written = write(fd[1], &results[next], sizeof(struct SimResult));
+                _exit(written == sizeof(struct SimResult) ? 0 : 1);
+            }
+            
+            close(fd[1]);
+            pids[next] = pid;
+            pipes[next] = fd[0];
+            next++;
+            running++;
+        }
+        
+        pid_t done = waitpid(-1, &status, 0);
+        
+        for (i = 0; i < next; i++)
+        {
+            if (pids[i] == done)
+            {
+                if (read(pipes[i], &results[i], sizeof(struct SimResult)) != sizeof(struct SimResult))
+                {
+                    results[i].status = 1;
+                }
+                
+                if (results[i].status != 0)
+                {
+                    failures++;
+                }
+                
+                close(pipes[i]);
+                pids[i] = 0;
+                running--;
+                break;
+            }
+        }
+    }
+    
+    free(pids);
+    free(pipes);
+    
+    return failures;
+}
+
+/*
+ * Evaluates the sweep_min..sweep_max grid of (map_cf, reduce_cf) pairs and writes
+ * every result to HDMSG_output.txt in grid order.
+ */
+int runSweep()
+{
+    int i, j;
+    struct timeval start, end;
+    
+    // An inverted range would give no steps, or a negative count
+    if (sweep_min > sweep_max)
+    {
+        fprintf(stderr, "sweep_min %g is above sweep_max %g.\n", sweep_min, sweep_max);
+        return 1;
+    }
+    
+    int steps = (int) floor((sweep_max - sweep_min) / sweep_step + 0.5) + 1;
+    int count = steps * steps;
+    int workers = get_worker_count(sweep_workers);
+    
+    struct SimResult *results = xbt_new0(struct SimResult, count);
+    
+    // Compute each factor from its index so the grid does not accumulate rounding error
+    for (i = 0; i < steps; i++)
+    {
+        for (j = 0; j < steps; j++)
+        {
+            initSimResult(&results[i * steps + j], sweep_min + i * sweep_step, sweep_min + j * sweep_step);
+        }
+    }
+    
+    printf("\nExecuting %d combinations on %d workers\n", count, workers);
+    
+    gettimeofday(&start, NULL);
+    int failures = runParallel(results, count, workers, runSimulation);
+    gettimeofday(&end, NULL);
+    
+    FILE * output_file = fopen("HDMSG_output.txt", "w");
+    
+    if (output_file == NULL)
+    {
+        fprintf(stderr, "Error while opening HDMSG_output.txt.\n");
+        free(results);
+        return 1;
+    }
+    
+    fprintf(output_file, "map_cf reduce_cf sim_map actual_map sim_reduce actual_reduce sim_elap actual_elap sim_err sum_of_diffs avg_percent_diff\n");
+    
+    struct SimResult *best = NULL;
+    
+    for (i = 0; i < count; i++)
+    {
+        if (results[i].status != 0)
+        {
+            continue;
+        }
+        
+        writeSimResult(output_file, &results[i]);
+        
+        // Same ranking as exhaustiveSearch.py: lowest percent diff among runs within 1% of the actual time
+        if (results[i].has_actual && results[i].sim_err < 1)
+        {
+            if (best == NULL || results[i].avg_percent_diff < best->avg_percent_diff)
+            {
+                best = &results[i];
+            }
+        }
+    }
+    
+    fclose(output_file);
+    
+    printf("Completed in %.2f seconds, %d failed\n",
+           (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6,
+           failures);
+    
+    if (best != NULL)
+    {
+        printf("Best: map_cf %.2f reduce_cf %.2f sim_err %.2f%% avg_percent_diff %.2f%%\n",
+               best->map_calibration_factor,
+               best->reduce_calibration_factor,
+               best->sim_err,
+               best->avg_percent_diff);
+    }
+    
+    free(results);
+    
+    return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,75 @@
+//
+//  HdmsgSweep.h
+//  HDMSG
+//
+
+#ifndef HDMSGSWEEP_H
+#define HDMSGSWEEP_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgFailure.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern double sweep_min;
+extern double sweep_max;
+extern double sweep_step;
+extern int sweep_workers;
+
+//////////////////////
+// Types
+//////////////////////
+
+// Inputs (calibration factors and job configuration) and outputs of one simulation
+struct SimResult
+{
+    double map_calibration_factor;
+    double reduce_calibration_factor;
+    
+    long input_size;        // In MB
+    long hdfs_chunk_size;   // In MB
+    long reducers;
+    
+    double sim_map;
+    double sim_reduce;
+    double simulation_time;
+    long events;            // Blocking MSG calls made by HDMSG processes
+    unsigned long seed;     // Seeds every random choice of the run
+    
+    long node_local_maps;   // Map tasks by where their HDFS block was read from
+    long rack_local_maps;
+    long remote_maps;
+    
+    int failure_scenario;           // Scenario of failure_hosts injected, from 1, or 0 for none
+    struct FailureStats failures;
+    
+    int has_actual;     // 0 if there are no cluster measurements for this configuration
+    double actual_map;
+    double actual_reduce;
+    double actual_exec;
+    
+    double sim_err;
+    double sum_of_diffs;
+    double avg_percent_diff;
+    
+    int status;         // 0 if the simulation ran to completion
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+
+// Defined in HDMSG.c
+void initSimResult(struct SimResult *, double, double);
+void runSimulation(struct SimResult *);
+void writeSimResult(FILE *, struct SimResult *);
+void compareToActual(struct SimResult *);
+
+int get_worker_count(int);
+int runParallel(struct SimResult *, int, int, void (*)(struct SimResult *));
+int runSweep();
+
+#endif /* HdmsgSweep_h */
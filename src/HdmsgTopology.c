@@ -0,0 +1,186 @@
+//
+//  HdmsgTopology.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HdmsgTopology.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// Racks are read from the platform: every innermost AS is a rack, so a platform of several
+// <cluster>s behind a core switch has one rack per cluster. How oversubscribed a rack is
+// comes from the bandwidth of its uplink in the platform, as SimGrid shares it among the
+// copies crossing it.
+xbt_dynar_t racks = NULL;
+
+struct ShuffleTraffic shuffle_traffic;
+
+static const char *traffic_names[] = { "node-local", "rack-local", "cross-rack" };
+
+/** Returns the rack_id of the rack with this name, adding the rack if it is new */
+static int get_rack_id(const char *name)
+{
+    unsigned int cpt;
+    struct Rack *rack;
+    
+    xbt_dynar_foreach(racks, cpt, rack)
+    {
+        if (strcmp(rack->name, name) == 0)
+        {
+            return cpt;
+        }
+    }
+    
+    rack = xbt_new0(struct Rack, 1);
+    rack->name = name;
+    rack->worker_hosts = xbt_dynar_new(sizeof(struct HdmsgHost *), NULL);
+    xbt_dynar_push(racks, &rack);
+    
+    return xbt_dynar_length(racks) - 1;
+}
+
+struct Rack *get_rack(struct HdmsgHost *hdmsg_host)
+{
+    return xbt_dynar_get_as(racks, hdmsg_host->rack_id, struct Rack *);
+}
+
+/*
+ * Each host's rack is the innermost AS of the platform that contains it.
+ */
+static void assign_as_racks(msg_as_t as)
+{
+    char * key;
+    msg_as_t son;
+    msg_host_t msg_host;
+    unsigned int cpt;
+    xbt_dict_cursor_t cursor = NULL;
+    
+    xbt_dict_foreach(MSG_environment_as_get_routing_sons(as), cursor, key, son)
+    {
+        assign_as_racks(son);
+    }
+    
+    xbt_dynar_t as_hosts = MSG_environment_as_get_hosts(as);
+    xbt_dynar_foreach(as_hosts, cpt, msg_host)
+    {
+        struct HdmsgHost *hdmsg_host = get_hdmsg_host(msg_host);
+        
+        if (hdmsg_host != NULL && hdmsg_host->rack == NULL)
+        {
+            hdmsg_host->rack = MSG_environment_as_get_name(as);
+            hdmsg_host->rack_id = get_rack_id(hdmsg_host->rack);
+            
+            if (hdmsg_host->is_worker)
+            {
+                struct Rack *rack = get_rack(hdmsg_host);
+                rack->workers++;
+                rack->cores += MSG_host_get_core_number(hdmsg_host->host);
+                xbt_dynar_push(rack->worker_hosts, &hdmsg_host);
+            }
+        }
+    }
+}
+
+void assignRacks()
+{
+    racks = xbt_dynar_new(sizeof(struct Rack *), NULL);
+    assign_as_racks(MSG_environment_get_routing_root());
+}
+
+int same_rack(struct HdmsgHost *a, struct HdmsgHost *b)
+{
+    return (a->rack != NULL && b->rack != NULL && a->rack_id == b->rack_id);
+}
+
+/*
+ * Returns how much of a task type a host can take on with the given slots. Each slot counts
+ * once, unless heterogeneous_speeds makes slower hosts take proportionally longer, in which
+ * case each counts by the host's speed relative to the fastest worker.
+ */
+double get_capacity(struct HdmsgHost *this_host, long slots)
+{
+    if (!heterogeneous_speeds)
+    {
+        return slots;
+    }
+    
+    return slots * MSG_host_get_speed(this_host->host) / get_reference_speed(this_host->host);
+}
+
+/*
+ * Accounts for one shuffle copy from the host holding a map output to its reducer's host,
+ * started at start_time and just finished
+ */
+void recordShuffleTraffic(struct HdmsgHost *source, struct HdmsgHost *destination, double start_time, double bytes)
+{
+    int traffic = TRAFFIC_CROSS_RACK;
+    
+    if (source == destination)
+    {
+        traffic = TRAFFIC_NODE_LOCAL;
+    }
+    else if (same_rack(source, destination))
+    {
+        traffic = TRAFFIC_RACK_LOCAL;
+    }
+    else if (source->rack != NULL && destination->rack != NULL)
+    {
+        get_rack(source)->cross_rack_out += bytes;
+        get_rack(destination)->cross_rack_in += bytes;
+    }
+    
+    shuffle_traffic.bytes[traffic] += bytes;
+    shuffle_traffic.copies[traffic]++;
+    shuffle_traffic.time[traffic] += MSG_get_clock() - start_time;
+}
+
+/** Logs the shuffle bytes and copy times within and across racks, and each rack's uplink traffic */
+void logShuffleTraffic()
+{
+    int traffic;
+    unsigned int cpt;
+    struct Rack *rack;
+    
+    double remote_bytes = shuffle_traffic.bytes[TRAFFIC_RACK_LOCAL] + shuffle_traffic.bytes[TRAFFIC_CROSS_RACK];
+    double total_bytes = shuffle_traffic.bytes[TRAFFIC_NODE_LOCAL] + remote_bytes;
+    
+    XBT_INFO("Shuffle traffic: %.1f MB node-local, %.1f MB rack-local, %.1f MB cross-rack, %.1f%% of the bytes over the network, %.1f%% across racks",
+             shuffle_traffic.bytes[TRAFFIC_NODE_LOCAL] / BYTES_PER_MEGABYTE,
+             shuffle_traffic.bytes[TRAFFIC_RACK_LOCAL] / BYTES_PER_MEGABYTE,
+             shuffle_traffic.bytes[TRAFFIC_CROSS_RACK] / BYTES_PER_MEGABYTE,
+             (total_bytes > 0) ? 100 * remote_bytes / total_bytes : 0,
+             (total_bytes > 0) ? 100 * shuffle_traffic.bytes[TRAFFIC_CROSS_RACK] / total_bytes : 0);
+    
+    for (traffic = TRAFFIC_NODE_LOCAL; traffic <= TRAFFIC_CROSS_RACK; traffic++)
+    {
+        if (shuffle_traffic.copies[traffic] > 0)
+        {
+            XBT_INFO("%s copies: %ld taking %.2f seconds on average, %.2f MB/s each",
+                     traffic_names[traffic],
+                     shuffle_traffic.copies[traffic],
+                     shuffle_traffic.time[traffic] / shuffle_traffic.copies[traffic],
+                     (shuffle_traffic.time[traffic] > 0) ? shuffle_traffic.bytes[traffic] / BYTES_PER_MEGABYTE / shuffle_traffic.time[traffic] : 0);
+        }
+    }
+    
+    if (xbt_dynar_length(racks) < 2)
+    {
+        return;
+    }
+    
+    xbt_dynar_foreach(racks, cpt, rack)
+    {
+        if (rack->workers > 0)
+        {
+            XBT_INFO("Rack %s: %d workers with %ld cores, %.1f MB shuffled out to other racks and %.1f MB in",
+                     rack->name,
+                     rack->workers,
+                     rack->cores,
+                     rack->cross_rack_out / BYTES_PER_MEGABYTE,
+                     rack->cross_rack_in / BYTES_PER_MEGABYTE);
+        }
+    }
+}
@@ -0,0 +1,68 @@
+//
+//  HdmsgTopology.h
+//  HDMSG
+//
+
+#ifndef HDMSGTOPOLOGY_H
+#define HDMSGTOPOLOGY_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+
+// Where a shuffle copy went, relative to the map output it copied
+#define TRAFFIC_NODE_LOCAL 0
+#define TRAFFIC_RACK_LOCAL 1
+#define TRAFFIC_CROSS_RACK 2
+
+extern xbt_dynar_t racks;       // struct Rack, indexed by HdmsgHost rack_id
+extern struct ShuffleTraffic shuffle_traffic;
+
+// Defined in HDMSG.c
+extern int BYTES_PER_MEGABYTE;
+extern int heterogeneous_speeds;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// One rack of the platform: the hosts of one innermost AS, such as a <cluster>
+struct Rack
+{
+    const char *name;
+    int workers;
+    long cores;                 // Of its workers
+    xbt_dynar_t worker_hosts;   // struct HdmsgHost * of its workers
+    
+    double cross_rack_out;      // Shuffle bytes copied from this rack to the others
+    double cross_rack_in;       // and from the others to this one, through its uplink
+};
+
+// Shuffle bytes, copies and copy time by TRAFFIC_NODE_LOCAL .. TRAFFIC_CROSS_RACK
+struct ShuffleTraffic
+{
+    double bytes[3];
+    long copies[3];
+    double time[3];             // Sum of the copy durations
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void assignRacks();
+struct Rack *get_rack(struct HdmsgHost *);
+int same_rack(struct HdmsgHost *, struct HdmsgHost *);
+double get_capacity(struct HdmsgHost *, long);
+void recordShuffleTraffic(struct HdmsgHost *, struct HdmsgHost *, double, double);
+void logShuffleTraffic();
+
+// Defined in HDMSG.c
+double get_reference_speed(msg_host_t);
+
+#endif /* HdmsgTopology_h */
@@ -0,0 +1,134 @@
+//
+//  HdmsgTrace.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HdmsgTrace.h"
+
+// Chrome Trace Event JSON, for chrome://tracing or ui.perfetto.dev. Each host is a process
+// of the trace and each simulated process a thread of it. NULL to disable tracing.
+char *trace_file = NULL;
+FILE *trace_output = NULL;
+
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+static char *trace_buffer;
+static int first_event;
+
+// Simulated processes that already have a thread_name record, indexed by PID
+static char *named_threads;
+static int named_threads_size;
+
+static void begin_event()
+{
+    fputs(first_event ? "\n" : ",\n", trace_output);
+    first_event = 0;
+}
+
+/*
+ * Names the trace thread of the current process the first time it records an event
+ */
+static void name_thread(int host_id, int pid)
+{
+    if (pid >= named_threads_size)
+    {
+        int size = (pid + 1) * 2;
+        named_threads = realloc(named_threads, size);
+        memset(named_threads + named_threads_size, 0, size - named_threads_size);
+        named_threads_size = size;
+    }
+    
+    if (named_threads[pid])
+    {
+        return;
+    }
+    
+    named_threads[pid] = 1;
+    begin_event();
+    fprintf(trace_output, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            host_id, pid, MSG_process_get_name(MSG_process_self()));
+}
+
+/*
+ * Opens trace_file and names a trace process after every host. Events are written through
+ * a large stdio buffer, so the simulation does not wait on the disk.
+ */
+void openTrace()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    
+    if (trace_file == NULL)
+    {
+        return;
+    }
+    
+    trace_output = fopen(trace_file, "w");
+    
+    if (trace_output == NULL)
+    {
+        fprintf(stderr, "Error while opening trace file %s.\n", trace_file);
+        exit(1);
+    }
+    
+    trace_buffer = malloc(TRACE_BUFFER_SIZE);
+    setvbuf(trace_output, trace_buffer, _IOFBF, TRACE_BUFFER_SIZE);
+    
+    first_event = 1;
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", trace_output);
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        begin_event();
+        fprintf(trace_output, "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+                hdmsg_host->host_id, hdmsg_host->host_name);
+    }
+}
+
+void closeTrace()
+{
+    if (trace_output == NULL)
+    {
+        return;
+    }
+    
+    fputs("\n]}\n", trace_output);
+    fclose(trace_output);
+    trace_output = NULL;
+    
+    free(trace_buffer);
+    free(named_threads);
+    named_threads = NULL;
+    named_threads_size = 0;
+}
+
+/*
+ * Records a span of the current process, from start_time to now, with the bytes it moved
+ */
+void traceSpan(const char *category, const char *name, double start_time, double bytes)
+{
+    struct HdmsgHost *this_host = get_hdmsg_host(MSG_host_self());
+    int pid = MSG_process_get_PID(MSG_process_self());
+    
+    name_thread(this_host->host_id, pid);
+    
+    // Timestamps are in microseconds of simulated time
+    begin_event();
+    fprintf(trace_output, "{\"ph\":\"X\",\"cat\":\"%s\",\"name\":\"%s\",\"pid\":%d,\"tid\":%d,\"ts\":%.0f,\"dur\":%.0f,\"args\":{\"bytes\":%.0f}}",
+            category, name, this_host->host_id, pid,
+            start_time * 1e6, (MSG_get_clock() - start_time) * 1e6, bytes);
+}
+
+/*
+ * Records a phase change as an instant event across the whole trace
+ */
+void tracePhase(const char *name)
+{
+    begin_event();
+    fprintf(trace_output, "{\"ph\":\"i\",\"s\":\"g\",\"cat\":\"phase\",\"name\":\"%s\",\"pid\":0,\"tid\":0,\"ts\":%.0f}",
+            name, MSG_get_clock() * 1e6);
+}
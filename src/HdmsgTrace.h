@@ -0,0 +1,35 @@
+//
+//  HdmsgTrace.h
+//  HDMSG
+//
+
+#ifndef HDMSGTRACE_H
+#define HDMSGTRACE_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern char *trace_file;
+extern FILE *trace_output;
+
+// Tracing costs one test per call site when it is off
+#define TRACE_SPAN(category, name, start_time, bytes) \
+    do { if (trace_output != NULL) { traceSpan((category), (name), (start_time), (bytes)); } } while (0)
+
+#define TRACE_PHASE(name) \
+    do { if (trace_output != NULL) { tracePhase(name); } } while (0)
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void openTrace();
+void closeTrace();
+void traceSpan(const char *, const char *, double, double);
+void tracePhase(const char *);
+
+#endif /* HdmsgTrace_h */
@@ -0,0 +1,452 @@
+//
+//  HdmsgWorkload.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include "HdmsgWorkload.h"
+#include "HdmsgRandom.h"
+#include "HdmsgYarn.h"
+#include "HdmsgSpeculate.h"
+#include "HdmsgDisk.h"
+#include "HdmsgTrace.h"
+#include "HdmsgMetrics.h"
+#include "HdmsgPool.h"
+#include "HdmsgTopology.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// The trace has one job per line: name arrival_s input_mb chunk_mb reducers [queue]
+// Lines starting with # are comments. Jobs without a queue go to "default".
+char *workload_file = NULL;
+
+// Decides which job a node grants a free container to when several wait for one.
+// "fifo" grants it to the earliest submitted job.
+// "fair" grants it to the job with the fewest running tasks.
+// "capacity" grants it to the queue furthest below its capacity, then FIFO within the queue.
+char *workload_scheduler = "fifo";
+
+// Comma separated queue:capacity pairs, e.g. "prod:0.7,adhoc:0.3". Unset, every queue in
+// the trace gets an equal share.
+char *workload_queues = NULL;
+
+// Seconds between samples of the busy containers
+double workload_sample_interval = 10;
+
+static struct HdmsgJob **jobs;
+static long number_of_jobs;
+static long submitted_jobs;     // Jobs are submitted in trace order, so these are jobs[0 .. submitted_jobs)
+
+static xbt_dict_t queues;
+
+// One slot per container of the larger of the map and reduce capacity of each worker
+static long total_slots;
+
+static xbt_dynar_t samples;     // struct WorkloadSample
+
+struct WorkloadSample
+{
+    double time;
+    long busy_slots;
+};
+
+static struct WorkloadQueue *get_queue(const char *name)
+{
+    struct WorkloadQueue *queue = xbt_dict_get_or_null(queues, name);
+    
+    if (queue == NULL)
+    {
+        queue = xbt_new0(struct WorkloadQueue, 1);
+        queue->name = xbt_strdup(name);
+        queue->capacity = 0;
+        xbt_dict_set(queues, name, queue, NULL);
+    }
+    
+    return queue;
+}
+
+/*
+ * Creates the configured capacity queues. Queues first seen in the trace get an equal share
+ * of what the configured ones leave.
+ */
+static void read_queues()
+{
+    queues = xbt_dict_new();
+    
+    if (workload_queues == NULL)
+    {
+        return;
+    }
+    
+    char *pairs = xbt_strdup(workload_queues);
+    char *cursor_pairs = pairs;
+    char *pair;
+    
+    while ((pair = strsep(&cursor_pairs, ",")) != NULL)
+    {
+        char *name = strsep(&pair, ":");
+        xbt_assert(pair != NULL, "Queue without a capacity in workload_queues: %s", name);
+        get_queue(name)->capacity = atof(pair);
+    }
+    
+    free(pairs);
+}
+
+static void share_unconfigured_capacity()
+{
+    char * key;
+    struct WorkloadQueue * queue;
+    xbt_dict_cursor_t cursor = NULL;
+    double configured = 0;
+    long unconfigured = 0;
+    
+    xbt_dict_foreach(queues, cursor, key, queue)
+    {
+        configured += queue->capacity;
+        unconfigured += (queue->capacity == 0) ? 1 : 0;
+    }
+    
+    xbt_dict_foreach(queues, cursor, key, queue)
+    {
+        if (queue->capacity == 0)
+        {
+            queue->capacity = fmax(1 - configured, 0.01) / unconfigured;
+        }
+    }
+}
+
+static int compare_arrivals(const void *a, const void *b)
+{
+    const struct HdmsgJob *job_a = *(struct HdmsgJob * const *) a;
+    const struct HdmsgJob *job_b = *(struct HdmsgJob * const *) b;
+    
+    if (job_a->arrival_time != job_b->arrival_time)
+    {
+        return (job_a->arrival_time < job_b->arrival_time) ? -1 : 1;
+    }
+    
+    return job_a->job_id - job_b->job_id;
+}
+
+/** Read the workload trace into jobs, in order of arrival */
+static void read_trace()
+{
+    char line[512];
+    char name[256];
+    char queue[256];
+    double arrival;
+    long input_mb, chunk_mb, job_reducers;
+    int line_number = 0;
+    
+    FILE * trace_file = fopen(workload_file, "r");
+    
+    if (trace_file == NULL)
+    {
+        fprintf(stderr, "Error while opening workload trace %s.\n", workload_file);
+        exit(1);
+    }
+    
+    xbt_dynar_t parsed = xbt_dynar_new(sizeof(struct HdmsgJob *), NULL);
+    
+    while (fgets(line, sizeof(line), trace_file) != NULL)
+    {
+        line_number++;
+        line[strcspn(line, "\n")] = 0;
+        
+        if (line[0] == '#' || strspn(line, " \t") == strlen(line))
+        {
+            continue;
+        }
+        
+        strcpy(queue, "default");
+        
+        int fields = sscanf(line, "%255s %lf %ld %ld %ld %255s", name, &arrival, &input_mb, &chunk_mb, &job_reducers, queue);
+        
+        if (fields < 5 || input_mb <= 0 || chunk_mb <= 0 || job_reducers < 0)
+        {
+            fprintf(stderr, "Error in workload trace line %d: %s\n", line_number, line);
+            exit(1);
+        }
+        
+        // A last partial chunk is a map task of its own, modeled as a full one
+        struct HdmsgJob *job = newHdmsgJob(line_number, xbt_strdup(name), input_mb, chunk_mb, job_reducers);
+        job->map_tasks = (input_mb + chunk_mb - 1) / chunk_mb;
+        job->queue = get_queue(queue);
+        job->arrival_time = arrival;
+        
+        xbt_dynar_push(parsed, &job);
+    }
+    
+    fclose(trace_file);
+    
+    number_of_jobs = xbt_dynar_length(parsed);
+    xbt_assert(number_of_jobs > 0, "The workload trace %s has no jobs", workload_file);
+    
+    jobs = xbt_dynar_to_array(parsed);
+    qsort(jobs, number_of_jobs, sizeof(struct HdmsgJob *), compare_arrivals);
+}
+
+static double get_queue_usage(struct WorkloadQueue *queue)
+{
+    return queue->running_tasks / queue->capacity;
+}
+
+/*
+ * Returns 1 if the scheduler gives a free container to job a before job b. Ties go to the
+ * earlier job.
+ */
+int workloadRunsFirst(struct HdmsgJob *a, struct HdmsgJob *b)
+{
+    if (strcmp(workload_scheduler, "fair") == 0 && a->running_tasks != b->running_tasks)
+    {
+        return (a->running_tasks < b->running_tasks);
+    }
+    
+    if (strcmp(workload_scheduler, "capacity") == 0 && get_queue_usage(a->queue) != get_queue_usage(b->queue))
+    {
+        return (get_queue_usage(a->queue) < get_queue_usage(b->queue));
+    }
+    
+    return (compare_arrivals(&a, &b) < 0);
+}
+
+/*
+ * Records the containers the submitted jobs hold
+ */
+static void record_sample()
+{
+    long i;
+    struct WorkloadSample sample;
+    sample.time = MSG_get_clock();
+    sample.busy_slots = 0;
+    
+    for (i = 0; i < submitted_jobs; i++)
+    {
+        sample.busy_slots += jobs[i]->running_tasks;
+    }
+    
+    xbt_dynar_push(samples, &sample);
+    
+    peak_processes = fmax(peak_processes, MSG_process_get_number());
+}
+
+/** Submitter Process: submits each job of the trace at its arrival time, with its own master */
+int workloadSubmitter(int argc, char * argv[])
+{
+    long i;
+    
+    for (i = 0; i < number_of_jobs; i++)
+    {
+        struct HdmsgJob *job = jobs[i];
+        
+        if (job->arrival_time > MSG_get_clock())
+        {
+            MSG_process_sleep(job->arrival_time - MSG_get_clock());
+            simulation_events++;
+        }
+        
+        submitted_jobs++;
+        XBT_INFO("JOB %s SUBMITTED to queue %s (%ld maps, %ld reducers)", job->name, job->queue->name, job->map_tasks, job->reducers);
+        
+        distributeHdfsChunks(job);
+        MSG_process_create(intern_name("%smaster", job->prefix), master, job, master_host->host);
+    }
+    
+    return 0;
+}
+
+/** Sampler Process: records the busy containers every workload_sample_interval seconds, until the last job ends the simulation */
+int workloadSampler(int argc, char * argv[])
+{
+    while (1)
+    {
+        record_sample();
+        MSG_process_sleep(workload_sample_interval);
+        simulation_events++;
+    }
+    
+    return 0;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x < y) ? -1 : (x > y);
+}
+
+/*
+ * Returns the nearest-rank percentile p (0 to 1) of sorted values
+ */
+static double get_percentile(double *sorted, long n, double p)
+{
+    long rank = (long) ceil(p * n);
+    rank = (rank < 1) ? 1 : rank;
+    return sorted[rank - 1];
+}
+
+static void write_workload_report(double makespan)
+{
+    long i;
+    unsigned int cpt;
+    struct WorkloadSample sample;
+    double *latencies = xbt_new(double, number_of_jobs);
+    double busy_time = 0;
+    double previous_time = 0;
+    long previous_busy = 0;
+    
+    FILE * jobs_file = fopen("HDMSG_jobs.txt", "w");
+    fprintf(jobs_file, "job queue arrival start finish latency maps reducers avg_map avg_reduce\n");
+    
+    printf("\nJob\t\tQueue\t\tArrival\t\tStart\t\tFinish\t\tLatency\n");
+    
+    for (i = 0; i < number_of_jobs; i++)
+    {
+        struct HdmsgJob *job = jobs[i];
+        latencies[i] = job->finish_time - job->arrival_time;
+        
+        fprintf(jobs_file, "%s %s %.2f %.2f %.2f %.2f %ld %ld %.2f %.2f\n",
+                job->name, job->queue->name, job->arrival_time, job->start_time, job->finish_time, latencies[i],
+                job->map_tasks, job->reducers,
+                job->sim_map / job->map_tasks,
+                (job->reducers > 0) ? job->sim_reduce / job->reducers : 0);
+        
+        printf("%-15s %-15s %-15.2f %-15.2f %-15.2f %.2f\n",
+               job->name, job->queue->name, job->arrival_time, job->start_time, job->finish_time, latencies[i]);
+    }
+    
+    fclose(jobs_file);
+    
+    qsort(latencies, number_of_jobs, sizeof(double), compare_doubles);
+    
+    double mean_latency = 0;
+    for (i = 0; i < number_of_jobs; i++)
+    {
+        mean_latency += latencies[i] / number_of_jobs;
+    }
+    
+    printf("\nJob latency: mean %.2f, p50 %.2f, p90 %.2f, p95 %.2f, p99 %.2f, max %.2f\n",
+           mean_latency,
+           get_percentile(latencies, number_of_jobs, 0.50),
+           get_percentile(latencies, number_of_jobs, 0.90),
+           get_percentile(latencies, number_of_jobs, 0.95),
+           get_percentile(latencies, number_of_jobs, 0.99),
+           latencies[number_of_jobs - 1]);
+    
+    free(latencies);
+    
+    // Utilization over time, one line per sample
+    FILE * utilization_file = fopen("HDMSG_utilization.txt", "w");
+    fprintf(utilization_file, "time busy_slots total_slots utilization\n");
+    
+    xbt_dynar_foreach(samples, cpt, sample)
+    {
+        fprintf(utilization_file, "%.2f %ld %ld %.4f\n", sample.time, sample.busy_slots, total_slots, (double) sample.busy_slots / total_slots);
+        
+        // Each sample's busy containers hold until the next one. Tasks waiting for a container
+        // count in the hosts' busy time, so it is no measure of the slots in use here.
+        busy_time += previous_busy * (sample.time - previous_time);
+        previous_time = sample.time;
+        previous_busy = sample.busy_slots;
+    }
+    
+    fclose(utilization_file);
+    
+    printf("Makespan %.2f seconds, cluster utilization %.1f%% of %ld slots (over time in HDMSG_utilization.txt)\n\n",
+           makespan, 100 * busy_time / (total_slots * makespan), total_slots);
+}
+
+/*
+ * Simulates every job of the workload trace on one cluster. Each job runs through its own
+ * master, mappers, shuffle and reducers, and the jobs share the nodes' containers through
+ * the configured scheduler. Prints per-job latencies and writes them to HDMSG_jobs.txt.
+ */
+int runWorkload(double map_cf, double reduce_cf)
+{
+    long i;
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    msg_error_t res = MSG_OK;
+    
+    xbt_assert(strcmp(workload_scheduler, "fifo") == 0 ||
+               strcmp(workload_scheduler, "fair") == 0 ||
+               strcmp(workload_scheduler, "capacity") == 0,
+               "Unknown workload scheduler: %s", workload_scheduler);
+    
+    MAP_CALIBRATION_FACTOR = map_cf;
+    REDUCE_CALIBRATION_FACTOR = reduce_cf;
+    
+    // The scheduler decides between jobs when it grants a container. Without the container
+    // model, every core is a container of its own.
+    if (!containers_enabled())
+    {
+        yarn_node_memory_mb = LONG_MAX / 2;
+        yarn_node_vcores = 0;
+        map_container_vcores = 1;
+        reduce_container_vcores = 1;
+        assignContainerResources();
+    }
+    
+    read_queues();
+    read_trace();
+    share_unconfigured_capacity();
+    
+    seedRandom(random_seed);
+    memset(map_locality, 0, sizeof(map_locality));
+    chooseStragglerHosts();
+    unfinished_jobs = number_of_jobs;
+    
+    samples = xbt_dynar_new(sizeof(struct WorkloadSample), NULL);
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            total_slots += fmax(get_container_capacity(hdmsg_host, CONTAINER_MAP), get_container_capacity(hdmsg_host, CONTAINER_REDUCE));
+        }
+    }
+    
+    MSG_process_create("submitter", workloadSubmitter, NULL, master_host->host);
+    MSG_process_create("sampler", workloadSampler, NULL, master_host->host);
+    
+    openTrace();
+    openMetrics();
+    res = MSG_main();
+    closeMetrics();
+    closeTrace();
+    
+    double makespan = 0;
+    for (i = 0; i < number_of_jobs; i++)
+    {
+        makespan = fmax(makespan, jobs[i]->finish_time);
+    }
+    
+    // The last job killed the sampler, so the last sample is taken here
+    record_sample();
+    
+    XBT_INFO("Simulation time %g", makespan);
+    XBT_INFO("Simulation events %ld", simulation_events);
+    XBT_INFO("Simulation processes %d at most", peak_processes);
+    XBT_INFO("Map locality: %ld node-local, %ld rack-local, %ld remote",
+             map_locality[HDFS_NODE_LOCAL], map_locality[HDFS_RACK_LOCAL], map_locality[HDFS_REMOTE]);
+    logShuffleTraffic();
+    
+    if (work_stealing)
+    {
+        XBT_INFO("Stolen map tasks %ld", stolen_maps);
+    }
+    
+    if (speculative_execution)
+    {
+        logSpeculationReport();
+    }
+    
+    write_workload_report(makespan);
+    
+    return (res == MSG_OK) ? 0 : 1;
+}
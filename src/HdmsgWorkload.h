@@ -0,0 +1,57 @@
+//
+//  HdmsgWorkload.h
+//  HDMSG
+//
+
+#ifndef HDMSGWORKLOAD_H
+#define HDMSGWORKLOAD_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+#include "HdmsgHdfs.h"
+
+//////////////////////
+// Constants
+//////////////////////
+extern char *workload_file;
+extern char *workload_scheduler;
+extern char *workload_queues;
+extern double workload_sample_interval;
+
+// Defined in HDMSG.c
+extern long simulation_events;
+extern int peak_processes;
+extern double MAP_CALIBRATION_FACTOR;
+extern double REDUCE_CALIBRATION_FACTOR;
+extern struct HdmsgHost *master_host;
+extern long unfinished_jobs;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// A queue of the capacity scheduler, guaranteed its capacity as a fraction of the slots
+struct WorkloadQueue
+{
+    char *name;
+    double capacity;
+    int running_tasks;
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+int runWorkload(double, double);
+int workloadRunsFirst(struct HdmsgJob *, struct HdmsgJob *);
+
+int workloadSubmitter(int argc, char * argv[]);
+int workloadSampler(int argc, char * argv[]);
+
+// Defined in HDMSG.c
+int master(int argc, char *argv[]);
+void distributeHdfsChunks(struct HdmsgJob *);
+
+#endif /* HdmsgWorkload_h */
@@ -0,0 +1,261 @@
+//
+//  HdmsgYarn.c
+//  HDMSG
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "HdmsgYarn.h"
+#include "HdmsgWorkload.h"
+
+XBT_LOG_EXTERNAL_DEFAULT_CATEGORY(hdmsgCat);
+
+// NodeManager resources of every worker (yarn.nodemanager.resource.memory-mb and cpu-vcores).
+// A host property yarn_memory_mb or yarn_vcores in the platform file overrides them for one node.
+// With yarn_node_memory_mb at 0 there is no container model and every core runs one task.
+long yarn_node_memory_mb = 0;
+int yarn_node_vcores = 0;           // 0 for the host's core count
+
+// Container size of each task (mapreduce.map.memory.mb, mapreduce.map.cpu.vcores, ...)
+long map_container_mb = 1024;
+int map_container_vcores = 1;
+long reduce_container_mb = 1024;
+int reduce_container_vcores = 1;
+
+// Containers that had to wait for resources on their node
+long container_waits = 0;
+
+static long get_container_mb(int type)
+{
+    return (type == CONTAINER_MAP) ? map_container_mb : reduce_container_mb;
+}
+
+static int get_container_vcores(int type)
+{
+    return (type == CONTAINER_MAP) ? map_container_vcores : reduce_container_vcores;
+}
+
+int containers_enabled()
+{
+    return (yarn_node_memory_mb > 0);
+}
+
+/*
+ * Sets each worker's memory and vcores from the config and its platform properties
+ */
+void assignContainerResources()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        const char *memory = MSG_host_get_property_value(hdmsg_host->host, "yarn_memory_mb");
+        const char *vcores = MSG_host_get_property_value(hdmsg_host->host, "yarn_vcores");
+        
+        hdmsg_host->memory_mb = (memory != NULL) ? atol(memory) : yarn_node_memory_mb;
+        hdmsg_host->vcores = (vcores != NULL) ? atoi(vcores) : yarn_node_vcores;
+        
+        if (hdmsg_host->vcores <= 0)
+        {
+            hdmsg_host->vcores = MSG_host_get_core_number(hdmsg_host->host);
+        }
+        
+        hdmsg_host->free_memory_mb = hdmsg_host->memory_mb;
+        hdmsg_host->free_vcores = hdmsg_host->vcores;
+        
+        if (containers_enabled() && hdmsg_host->is_worker)
+        {
+            xbt_assert(get_container_capacity(hdmsg_host, CONTAINER_MAP) > 0 && get_container_capacity(hdmsg_host, CONTAINER_REDUCE) > 0,
+                       "Map and reduce containers must both fit on %s", hdmsg_host->host_name);
+        }
+    }
+}
+
+/*
+ * Returns the number of containers of a type that fit on an idle host, or its cores
+ * without the container model
+ */
+long get_container_capacity(struct HdmsgHost *this_host, int type)
+{
+    if (!containers_enabled())
+    {
+        return MSG_host_get_core_number(this_host->host);
+    }
+    
+    long by_memory = this_host->memory_mb / get_container_mb(type);
+    long by_vcores = this_host->vcores / get_container_vcores(type);
+    
+    return (by_memory < by_vcores) ? by_memory : by_vcores;
+}
+
+/*
+ * Returns the number of map tasks a host can run at once
+ */
+long get_map_slots(struct HdmsgHost *this_host)
+{
+    return get_container_capacity(this_host, CONTAINER_MAP);
+}
+
+static int fits(struct HdmsgHost *this_host, long memory_mb, int vcores)
+{
+    return (this_host->free_memory_mb >= memory_mb && this_host->free_vcores >= vcores);
+}
+
+/*
+ * Returns 1 if the host can give a job a container of a type now. In a workload, pipelined
+ * reducers must leave room for a map container: reducers of several jobs could otherwise
+ * hold a node while the maps they wait for cannot start there.
+ */
+static int can_grant(struct HdmsgHost *this_host, int type, struct HdmsgJob *job)
+{
+    if (type == CONTAINER_REDUCE && pipelined_reduce && job->queue != NULL)
+    {
+        return fits(this_host, reduce_container_mb + map_container_mb, reduce_container_vcores + map_container_vcores);
+    }
+    
+    return fits(this_host, get_container_mb(type), get_container_vcores(type));
+}
+
+static void take_container(struct HdmsgHost *this_host, int type, struct HdmsgJob *job)
+{
+    this_host->free_memory_mb -= get_container_mb(type);
+    this_host->free_vcores -= get_container_vcores(type);
+    
+    job->running_tasks++;
+    if (job->queue != NULL)
+    {
+        job->queue->running_tasks++;
+    }
+}
+
+static int has_request(struct HdmsgHost *this_host, struct HdmsgJob *job)
+{
+    xbt_fifo_item_t bucket;
+    struct ContainerRequest *request;
+    
+    xbt_fifo_foreach(this_host->container_requests, bucket, request, struct ContainerRequest *)
+    {
+        if (request->job == job)
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/*
+ * Returns the waiting request to grant next, or NULL if none can be granted. Each job's
+ * requests are granted in order, and the workload scheduler decides between jobs.
+ */
+static struct ContainerRequest *next_request(struct HdmsgHost *this_host)
+{
+    xbt_fifo_item_t bucket;
+    struct ContainerRequest *request;
+    struct ContainerRequest *best = NULL;
+    xbt_dynar_t seen = xbt_dynar_new(sizeof(struct HdmsgJob *), NULL);
+    
+    xbt_fifo_foreach(this_host->container_requests, bucket, request, struct ContainerRequest *)
+    {
+        if (xbt_dynar_member(seen, &request->job))
+        {
+            continue;
+        }
+        
+        xbt_dynar_push(seen, &request->job);
+        
+        if (can_grant(this_host, request->type, request->job) &&
+            (best == NULL || workloadRunsFirst(request->job, best->job)))
+        {
+            best = request;
+        }
+    }
+    
+    xbt_dynar_free(&seen);
+    return best;
+}
+
+/*
+ * Takes a container of a type on a host for a job, waiting behind the job's earlier
+ * requests until the host has the memory and vcores for it
+ */
+void allocate_container(struct HdmsgHost *this_host, int type, struct HdmsgJob *job)
+{
+    if (!containers_enabled())
+    {
+        return;
+    }
+    
+    if (!has_request(this_host, job) && can_grant(this_host, type, job))
+    {
+        take_container(this_host, type, job);
+        return;
+    }
+    
+    // release_container() takes the resources on this request's behalf when it grants it
+    struct ContainerRequest request;
+    request.type = type;
+    request.job = job;
+    request.granted = MSG_sem_init(0);
+    
+    xbt_fifo_push(this_host->container_requests, &request);
+    container_waits++;
+    
+    MSG_sem_acquire(request.granted);
+    simulation_events++;
+    MSG_sem_destroy(request.granted);
+}
+
+/*
+ * Gives a container's resources back to its host and grants the waiting requests that
+ * now fit
+ */
+void release_container(struct HdmsgHost *this_host, int type, struct HdmsgJob *job)
+{
+    struct ContainerRequest *request;
+    
+    if (!containers_enabled())
+    {
+        return;
+    }
+    
+    this_host->free_memory_mb += get_container_mb(type);
+    this_host->free_vcores += get_container_vcores(type);
+    
+    job->running_tasks--;
+    if (job->queue != NULL)
+    {
+        job->queue->running_tasks--;
+    }
+    
+    while ((request = next_request(this_host)) != NULL)
+    {
+        xbt_fifo_remove(this_host->container_requests, request);
+        take_container(this_host, request->type, request->job);
+        MSG_sem_release(request->granted);
+    }
+}
+
+void logContainerReport()
+{
+    char * key;
+    struct HdmsgHost * hdmsg_host;
+    xbt_dict_cursor_t cursor = NULL;
+    
+    xbt_dict_foreach(hosts, cursor, key, hdmsg_host)
+    {
+        if (hdmsg_host->is_worker)
+        {
+            XBT_INFO("%s containers: %ld MB and %d vcores, %ld map or %ld reduce at once",
+                     hdmsg_host->host_name,
+                     hdmsg_host->memory_mb,
+                     hdmsg_host->vcores,
+                     get_container_capacity(hdmsg_host, CONTAINER_MAP),
+                     get_container_capacity(hdmsg_host, CONTAINER_REDUCE));
+        }
+    }
+    
+    XBT_INFO("Containers that waited for resources %ld", container_waits);
+}
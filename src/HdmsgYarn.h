@@ -0,0 +1,56 @@
+//
+//  HdmsgYarn.h
+//  HDMSG
+//
+
+#ifndef HDMSGYARN_H
+#define HDMSGYARN_H
+
+#include <stdio.h>
+#include "simgrid/msg.h"
+#include "HdmsgHost.h"
+
+//////////////////////
+// Constants
+//////////////////////
+#define CONTAINER_MAP    0
+#define CONTAINER_REDUCE 1
+
+extern long yarn_node_memory_mb;
+extern int yarn_node_vcores;
+extern long map_container_mb;
+extern int map_container_vcores;
+extern long reduce_container_mb;
+extern int reduce_container_vcores;
+
+extern long container_waits;
+
+// Defined in HDMSG.c
+extern long simulation_events;
+
+
+//////////////////////
+// Types
+//////////////////////
+
+// A container waiting for its node to free enough memory and vcores
+struct ContainerRequest
+{
+    int type;
+    struct HdmsgJob *job;
+    msg_sem_t granted;
+};
+
+
+//////////////////////
+// Prototypes
+//////////////////////
+void assignContainerResources();
+int containers_enabled();
+long get_container_capacity(struct HdmsgHost *, int);
+long get_map_slots(struct HdmsgHost *);
+void allocate_container(struct HdmsgHost *, int, struct HdmsgJob *);
+void release_container(struct HdmsgHost *, int, struct HdmsgJob *);
+void logContainerReport();
+
+#endif /* HdmsgYarn_h */
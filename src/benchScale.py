@@ -0,0 +1,196 @@
+from __future__ import print_function
+
+import os
+import sys
+import time
+import shutil
+import signal
+import tempfile
+
+# Measures how HDMSG itself scales: wall-clock time, simulated events per second, peak RSS
+# and simulated processes on synthetic clusters, one point at a time.
+#
+# Usage: python benchScale.py [--max-workers N] [--timeout seconds] [--baseline file]
+#
+# Results go to HDMSG_bench.txt. Pass an earlier HDMSG_bench.txt as --baseline to see how
+# each point changed.
+
+# (workers, cores per host, input MB, chunk MB, reducers)
+points = [(10, 4, 1024, 64, 10),
+          (10, 4, 10240, 64, 10),
+          (100, 4, 10240, 64, 100),
+          (100, 8, 102400, 128, 100),
+          (1000, 8, 102400, 128, 500),
+          (1000, 8, 1048576, 128, 1000),
+          (10000, 8, 1048576, 128, 1000),
+          (10000, 8, 10485760, 256, 1000)]
+
+columns = ['workers', 'cores', 'input_mb', 'chunk_mb', 'reducers', 'status',
+           'wall_s', 'events', 'events_per_s', 'rss_kb', 'processes', 'sim_time']
+
+# Changes above this fraction are flagged against the baseline
+regression_threshold = 0.10
+
+hdmsg = os.path.abspath('HDMSG')
+
+
+def write_platform(path, workers, cores):
+    with open(path, 'w') as f:
+        f.write("<?xml version='1.0'?>\n")
+        f.write('<!DOCTYPE platform SYSTEM "http://simgrid.gforge.inria.fr/simgrid/simgrid.dtd">\n')
+        f.write('<platform version="4">\n')
+        f.write('<AS id="AS0" routing="Full">\n')
+        f.write('<cluster id="cluster" prefix="host" suffix="" radical="0-' + str(workers) + '" speed="92000000flops" core="' + str(cores) + '" bw="90MBps" lat="75ms"/>\n')
+        f.write('</AS>\n')
+        f.write('</platform>\n')
+
+
+def write_config(path, workers, input_mb, chunk_mb, reducers):
+    with open(path, 'w') as f:
+        f.write('master host0\n')
+        f.write('worker host1-host' + str(workers) + '\n')
+        f.write('mappers 0\n')
+        f.write('reducers ' + str(reducers) + '\n')
+        f.write('input_size_in_mb ' + str(input_mb) + '\n')
+        f.write('hdfs_chunk_size_in_mb ' + str(chunk_mb) + '\n')
+
+
+def run_point(point, timeout):
+    """Simulates one point in a scratch directory and returns its row of measurements"""
+    workers, cores, input_mb, chunk_mb, reducers = point
+    directory = tempfile.mkdtemp(prefix='hdmsg_bench_')
+    platform = os.path.join(directory, 'platform.xml')
+    config = os.path.join(directory, 'config')
+    log = os.path.join(directory, 'log.txt')
+
+    write_platform(platform, workers, cores)
+    write_config(config, workers, input_mb, chunk_mb, reducers)
+
+    row = dict(zip(columns, list(point) + ['ok', 0, 0, 0, 0, 0, 0]))
+
+    # HDMSG writes its outputs to the working directory, so it runs in the scratch directory
+    start = time.time()
+    pid = os.fork()
+    if pid == 0:
+        os.chdir(directory)
+        fd = os.open(log, os.O_WRONLY | os.O_CREAT | os.O_TRUNC)
+        os.dup2(fd, 1)
+        os.dup2(fd, 2)
+        os.execv(hdmsg, [hdmsg, '1', '1', config, platform])
+
+    while True:
+        waited, status, usage = os.wait4(pid, os.WNOHANG)
+        if waited == pid:
+            break
+        if time.time() - start > timeout:
+            os.kill(pid, signal.SIGKILL)
+            waited, status, usage = os.wait4(pid, 0)
+            row['status'] = 'timeout'
+            break
+        time.sleep(0.05)
+
+    row['wall_s'] = time.time() - start
+    row['rss_kb'] = usage.ru_maxrss     # Kilobytes on Linux
+
+    if row['status'] == 'ok' and status != 0:
+        row['status'] = 'failed'
+
+    # The summary lines come after the simulation, so a timed out run has none
+    with open(log, 'r') as f:
+        for line in f:
+            if 'Simulation time' in line:
+                row['sim_time'] = float(line.split()[-1])
+            elif 'Simulation events' in line:
+                row['events'] = int(line.split()[-1])
+            elif 'Simulation processes' in line:
+                row['processes'] = int(line.split()[-3])
+
+    if row['wall_s'] > 0:
+        row['events_per_s'] = row['events'] / row['wall_s']
+
+    shutil.rmtree(directory)
+    return row
+
+
+def format_row(row):
+    return (str(row['workers']) + ' ' + str(row['cores']) + ' ' + str(row['input_mb']) + ' ' +
+            str(row['chunk_mb']) + ' ' + str(row['reducers']) + ' ' + row['status'] + ' ' +
+            '%.2f %d %.0f %d %d %.2f' % (row['wall_s'], row['events'], row['events_per_s'],
+                                         row['rss_kb'], row['processes'], row['sim_time']))
+
+
+def read_baseline(path):
+    """Returns the rows of an earlier HDMSG_bench.txt, keyed by their point"""
+    baseline = {}
+    with open(path, 'r') as f:
+        for line in f:
+            values = line.split()
+            if len(values) != len(columns) or values[0] == columns[0]:
+                continue
+            row = dict(zip(columns, values))
+            baseline[tuple(int(v) for v in values[:5])] = row
+    return baseline
+
+
+def compare(row, old):
+    """Returns how the row changed from its baseline, flagging regressions"""
+    if old is None:
+        return 'new point'
+    if old['status'] != 'ok' or row['status'] != 'ok':
+        return 'was ' + old['status']
+
+    changes = []
+    for column, higher_is_worse in [('wall_s', True), ('events_per_s', False), ('rss_kb', True)]:
+        before = float(old[column])
+        change = (row[column] - before) / before if before > 0 else 0
+        worse = change > regression_threshold if higher_is_worse else change < -regression_threshold
+        changes.append('%s %+.1f%%%s' % (column, 100 * change, ' REGRESSION' if worse else ''))
+
+    if row['events'] != int(old['events']) or abs(row['sim_time'] - float(old['sim_time'])) > 0.01:
+        changes.append('simulation changed')
+
+    return ', '.join(changes)
+
+
+max_workers = None
+timeout = 3600
+baseline = None
+
+args = sys.argv[1:]
+while args:
+    if args[0] == '--max-workers' and len(args) > 1:
+        max_workers = int(args[1])
+    elif args[0] == '--timeout' and len(args) > 1:
+        timeout = float(args[1])
+    elif args[0] == '--baseline' and len(args) > 1:
+        baseline = read_baseline(args[1])
+    else:
+        print('Usage: python benchScale.py [--max-workers N] [--timeout seconds] [--baseline file]')
+        sys.exit(1)
+    args = args[2:]
+
+if not os.path.isfile(hdmsg):
+    print('Build HDMSG first (make)')
+    sys.exit(1)
+
+print('\nWorkers\tCores\tInput\tChunk\tReducers\tStatus\tWall_s\tEvents\tEvents/s\tRSS_KB\tProcesses\tSim_Time')
+
+with open('HDMSG_bench.txt', 'w') as output:
+    output.write(' '.join(columns) + '\n')
+
+    for point in points:
+        if max_workers is not None and point[0] > max_workers:
+            continue
+
+        row = run_point(point, timeout)
+        output.write(format_row(row) + '\n')
+        output.flush()
+
+        print('\t'.join(format_row(row).split()))
+        if baseline is not None:
+            print('\t' + compare(row, baseline.get(point)))
+
+        # Larger points would only take longer
+        if row['status'] == 'timeout':
+            print('Stopped after a timeout at ' + str(point[0]) + ' workers')
+            break
@@ -1,7 +1,6 @@
 import os
 import sys
 import time
-import itertools
 import subprocess
 
 class ExpResult:
@@ -25,11 +24,6 @@ class ExpResult:
         self.exe_stats = self.sim_elap + ' , ' + self.actual_elap
         self.stats = [self.cfs, self.map_stats, self.reduce_stats, self.exe_stats, self.sum_of_diffs]
 
-def my_range(start, end, step):
-    while start <= end:
-        yield start
-        start += step
-
 def execute(command):
     process = subprocess.Popen(command, shell=True, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
     output = process.communicate()
@@ -49,64 +43,16 @@ with open('config', 'r') as f:
 config =  str(input_size) + "-" + str(chunk_size) + "-" + str(reducers)
 
 
-if os.path.isfile('HDMSG_output.txt'):
-    os.remove('HDMSG_output.txt')
-
-with open('HDMSG_output.txt', "w") as f:
-    f.write("map_cf reduce_cf sim_map actual_map sim_reduce actual_reduce sim_elap actual_elap sim_err sum_of_diffs avg_percent_diff\n");
-
 if os.path.isfile('ranked_output.txt'):
     os.remove('ranked_output.txt')
 
 execute("make")
 
-maps = []
-maps.extend(my_range(0.8, 1.2, 0.01))
-
-reduce = []
-reduce.extend(my_range(0.8, 1.2, 0.01))
-
-params = [maps, reduce]
-products = list(itertools.product(*params))
-length = len(products)
-
-print '\nExecuting ' + str(length) + ' combinations'
-
-sys.stdout.write('Progress: 0% ')
-sys.stdout.flush()
-
-count = 0.0
-procs = []
-fnull = open(os.devnull, 'w')
-
-i = 0
-progress = 10
-
-for product in products:
-
-    count += 1.0
-    
-    if length >= 100:
-        if count % (length / 10) == 0:
-            sys.stdout.write(str(progress) + '% ')
-            sys.stdout.flush()
-            progress += 10
-    
-    command = "./HDMSG " + str(product[0]) + " " + str(product[1]) + " config picluster.xml\n"
-    p = subprocess.Popen(command, shell=True, stdout=fnull, stderr=fnull)
-    procs.append(p)
-
-    if i == 10:
-        i = 0
-        for proc in procs:
-            proc.wait()
-            procs.remove(proc)
-    else:
-        i += 1
-
-for proc in procs:
-    proc.wait()
-    procs.remove(proc)
+# HDMSG parses the platform and config once, evaluates the whole calibration grid
+# on a pool of workers and writes every result to HDMSG_output.txt in grid order.
+# The grid defaults to 0.8 - 1.2 in steps of 0.01 (see sweep_* in the config file).
+print '\nExecuting calibration sweep'
+execute("./HDMSG --sweep config picluster.xml")
 
 results = []
 with open('HDMSG_output.txt', 'r') as f:
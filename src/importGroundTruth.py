@@ -0,0 +1,156 @@
+from __future__ import print_function
+
+import os
+import re
+import sys
+import datetime
+
+# Builds the ground-truth store HDMSG validates against from the Hadoop terminal output of
+# every run in Cluster Execution Data.
+#
+# Usage: python importGroundTruth.py [--data directory] [--platform name] [--output file]
+#
+# One line is written per run. HDMSG averages the runs of each (input, chunk, reducers)
+# measured on the platform it simulates. The platform is the platform file's name without
+# .xml, picluster for the data in this repository.
+#
+# Phases come from the "map X% reduce Y%" progress lines:
+#   map_s     first progress line to the first "map 100%"
+#   reduce_s  first "map 100%" to the first "reduce 100%"
+#   exec_s    map_s + reduce_s, the span HDMSG simulates
+#   elapsed_s submission to "completed successfully", - if the log stops before it
+
+columns = ['application', 'platform', 'input_mb', 'chunk_mb', 'reducers', 'job',
+           'map_s', 'reduce_s', 'exec_s', 'elapsed_s', 'shuffle_bytes', 'spilled_records']
+
+data_directory = '../Cluster Execution Data'
+platform = 'picluster'
+output_path = 'groundTruth.txt'
+
+MEGABYTE = 1048576
+
+
+def timestamp(line):
+    return datetime.datetime.strptime(line[:17], '%y/%m/%d %H:%M:%S')
+
+
+def seconds(start, end):
+    if start is None or end is None:
+        return None
+    return int((end - start).total_seconds())
+
+
+def counter(text, name):
+    """Returns a counter printed at the end of the job, or None if the log stops before it"""
+    match = re.search(r'^\s*' + re.escape(name) + r'=(\d+)', text, re.MULTILINE)
+    return int(match.group(1)) if match else None
+
+
+def path_number(path, pattern):
+    match = re.search(pattern, path)
+    return int(match.group(1)) if match else None
+
+
+def parse_run(path):
+    """Returns the row of one Terminal Output.txt, or None if it has no complete phases"""
+    with open(path, 'r') as f:
+        text = f.read()
+
+    submitted = first_progress = map_done = reduce_done = completed = None
+
+    for line in text.splitlines():
+        if not re.match(r'\d\d/\d\d/\d\d \d\d:\d\d:\d\d ', line):
+            continue
+
+        progress = re.search(r'map (\d+)% reduce (\d+)%', line)
+
+        if 'Submitted application' in line:
+            submitted = timestamp(line)
+        elif 'completed successfully' in line:
+            completed = timestamp(line)
+        elif progress:
+            first_progress = first_progress or timestamp(line)
+
+            if progress.group(1) == '100' and map_done is None:
+                map_done = timestamp(line)
+            if progress.group(2) == '100' and reduce_done is None:
+                reduce_done = timestamp(line)
+
+    map_s = seconds(first_progress, map_done)
+    reduce_s = seconds(map_done, reduce_done)
+
+    if map_s is None or reduce_s is None:
+        print('Skipped, the job did not finish: ' + path)
+        return None
+
+    job = re.search(r'job_(\d+_\d+)', text)
+    splits = re.search(r'number of splits:(\d+)', text)
+    reduces = re.search(r'mapreduce\.job\.reduces=(\d+)', text)
+    input_bytes = counter(text, 'Bytes Read')
+
+    # The job's own numbers win over the directory it was filed under
+    input_mb = int(round(float(input_bytes) / MEGABYTE)) if input_bytes else path_number(path, r'(\d+)MB Input')
+    chunk_mb = int(round(float(input_mb) / int(splits.group(1)))) if splits and input_mb else path_number(path, r'(\d+)MB Blocks')
+    reducers = int(reduces.group(1)) if reduces else (counter(text, 'Launched reduce tasks') or path_number(path, r'(\d+) Reducers'))
+
+    if None in (job, input_mb, chunk_mb, reducers):
+        print('Skipped, the configuration is unknown: ' + path)
+        return None
+
+    if (path_number(path, r'(\d+)MB Input'), path_number(path, r'(\d+)MB Blocks')) != (input_mb, chunk_mb):
+        print('Filed under the wrong configuration, using %d-%d-%d from the log: %s' % (input_mb, chunk_mb, reducers, path))
+
+    elapsed_s = seconds(submitted, completed)
+
+    return {'application': os.path.relpath(path, data_directory).split(os.sep)[0],
+            'platform': platform,
+            'input_mb': input_mb,
+            'chunk_mb': chunk_mb,
+            'reducers': reducers,
+            'job': job.group(1),
+            'map_s': map_s,
+            'reduce_s': reduce_s,
+            'exec_s': map_s + reduce_s,
+            'elapsed_s': elapsed_s if elapsed_s is not None else '-',
+            'shuffle_bytes': counter(text, 'Reduce shuffle bytes'),
+            'spilled_records': counter(text, 'Spilled Records')}
+
+
+args = sys.argv[1:]
+while args:
+    if args[0] == '--data' and len(args) > 1:
+        data_directory = args[1]
+    elif args[0] == '--platform' and len(args) > 1:
+        platform = args[1]
+    elif args[0] == '--output' and len(args) > 1:
+        output_path = args[1]
+    else:
+        print('Usage: python importGroundTruth.py [--data directory] [--platform name] [--output file]')
+        sys.exit(1)
+    args = args[2:]
+
+rows = {}
+
+for directory, subdirectories, files in sorted(os.walk(data_directory)):
+    subdirectories.sort()
+
+    if 'Terminal Output.txt' not in files:
+        continue
+
+    row = parse_run(os.path.join(directory, 'Terminal Output.txt'))
+
+    # The same job was sometimes saved in two places
+    if row is not None and row['job'] not in rows:
+        rows[row['job']] = row
+
+ordered = sorted(rows.values(), key=lambda r: (r['application'], r['input_mb'], r['chunk_mb'], r['reducers'], r['job']))
+
+with open(output_path, 'w') as output:
+    output.write('# Generated by importGroundTruth.py from ' + data_directory + '\n')
+    output.write(' '.join(columns) + '\n')
+
+    for row in ordered:
+        output.write(' '.join('-' if row[column] is None else str(row[column]) for column in columns) + '\n')
+
+print('%d runs of %d configurations written to %s' %
+      (len(ordered), len(set((r['input_mb'], r['chunk_mb'], r['reducers']) for r in ordered)), output_path))
@@ -0,0 +1,114 @@
+from __future__ import print_function
+
+import sys
+
+# Writes a multi-rack SimGrid platform: one <cluster> per rack, each behind a top-of-rack
+# switch, linked to a core switch through one uplink per rack. The uplink carries all of a
+# rack's cross-rack traffic, so its bandwidth sets the oversubscription: the rack's host
+# bandwidth over its uplink's. HDMSG treats each cluster as a rack.
+#
+# Usage: python makePlatform.py [--racks N] [--hosts-per-rack N,...] [--cores N,...]
+#            [--speeds MF,...] [--host-bw MBps] [--host-lat latency] [--oversubscription R]
+#            [--uplink-lat latency] [--output file]
+#
+# Lists give each rack its own value, taking turns when there are fewer values than racks,
+# so --speeds 92,46 alternates fast and slow racks. Hosts are numbered across the racks from
+# host0, and the master and worker lines for the config are printed.
+
+racks = 2
+hosts_per_rack = [4]
+cores = [4]
+speeds = [92]
+host_bw = 90
+host_lat = '75ms'
+oversubscription = 1.0
+uplink_lat = '100us'
+output = 'racks.xml'
+
+
+def int_list(value):
+    return [int(v) for v in value.split(',')]
+
+
+def float_list(value):
+    return [float(v) for v in value.split(',')]
+
+
+def for_rack(values, rack):
+    return values[rack % len(values)]
+
+
+def write_platform(path):
+    first_host = 0
+    rack_bws = []
+
+    with open(path, 'w') as f:
+        f.write("<?xml version='1.0'?>\n")
+        f.write('<!DOCTYPE platform SYSTEM "http://simgrid.gforge.inria.fr/simgrid/simgrid.dtd">\n')
+        f.write('<platform version="4">\n')
+        f.write('<AS id="AS0" routing="Full">\n')
+
+        # The top-of-rack switch is non-blocking, so hosts of one rack only share their own links
+        for rack in range(racks):
+            hosts = for_rack(hosts_per_rack, rack)
+            rack_bw = hosts * host_bw
+            rack_bws.append(rack_bw)
+            f.write('<cluster id="rack' + str(rack) + '" prefix="host" suffix="" radical="' + str(first_host) + '-' + str(first_host + hosts - 1) + '"'
+                    + ' speed="' + str(int(for_rack(speeds, rack) * 1000000)) + 'flops" core="' + str(for_rack(cores, rack)) + '"'
+                    + ' bw="' + str(host_bw) + 'MBps" lat="' + host_lat + '" bb_bw="' + str(rack_bw) + 'MBps" bb_lat="0"/>\n')
+            first_host += hosts
+
+        for rack in range(racks):
+            f.write('<link id="rack' + str(rack) + '-uplink" bandwidth="' + str(rack_bws[rack] / oversubscription) + 'MBps" latency="' + uplink_lat + '"/>\n')
+
+        # The core switch is non-blocking too: a cross-rack copy is limited by the two uplinks
+        for src in range(racks):
+            for dst in range(src + 1, racks):
+                f.write('<ASroute src="rack' + str(src) + '" dst="rack' + str(dst) + '"'
+                        + ' gw_src="hostrack' + str(src) + '_router" gw_dst="hostrack' + str(dst) + '_router">\n')
+                f.write('    <link_ctn id="rack' + str(src) + '-uplink"/>\n')
+                f.write('    <link_ctn id="rack' + str(dst) + '-uplink"/>\n')
+                f.write('</ASroute>\n')
+
+        f.write('</AS>\n')
+        f.write('</platform>\n')
+
+    return first_host
+
+
+args = sys.argv[1:]
+while args:
+    if args[0] == '--racks' and len(args) > 1:
+        racks = int(args[1])
+    elif args[0] == '--hosts-per-rack' and len(args) > 1:
+        hosts_per_rack = int_list(args[1])
+    elif args[0] == '--cores' and len(args) > 1:
+        cores = int_list(args[1])
+    elif args[0] == '--speeds' and len(args) > 1:
+        speeds = float_list(args[1])
+    elif args[0] == '--host-bw' and len(args) > 1:
+        host_bw = float(args[1])
+    elif args[0] == '--host-lat' and len(args) > 1:
+        host_lat = args[1]
+    elif args[0] == '--oversubscription' and len(args) > 1:
+        oversubscription = float(args[1])
+    elif args[0] == '--uplink-lat' and len(args) > 1:
+        uplink_lat = args[1]
+    elif args[0] == '--output' and len(args) > 1:
+        output = args[1]
+    else:
+        print('Usage: python makePlatform.py [--racks N] [--hosts-per-rack N,...] [--cores N,...] [--speeds MF,...] '
+              '[--host-bw MBps] [--host-lat latency] [--oversubscription R] [--uplink-lat latency] [--output file]')
+        sys.exit(1)
+    args = args[2:]
+
+if racks < 1 or min(hosts_per_rack) < 1 or oversubscription <= 0:
+    print('Need at least one rack of one host, and a positive oversubscription')
+    sys.exit(1)
+
+number_of_hosts = write_platform(output)
+
+print('Wrote ' + output + ': ' + str(racks) + ' racks, ' + str(number_of_hosts) + ' hosts, '
+      + str(oversubscription) + ':1 oversubscribed uplinks')
+print('master host0')
+print('worker host1-host' + str(number_of_hosts - 1))